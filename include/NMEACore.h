@@ -0,0 +1,738 @@
+/*
+  Project:  Yazz_Multiplexer.ino, Copyright 2020, Roy Wassili
+  File:     NMEACore.h
+  Purpose:  The part of the NMEAtor that handles NMEA0183 sentences without any
+            hardware: the tags and their IDs, the field views of a sentence, the
+            fixed point math and the rewrite rules of NMEA_SPECIALTY.
+            It is used by src/main.cpp and by the log tool in tools/nmealog, so a
+            recorded log is converted on a PC exactly the way it is on board.
+            All functions are inline and all tables const, so it can be included
+            anywhere.
+*/
+#ifndef NMEACORE_H
+#define NMEACORE_H
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+//*** a host build; flash is just memory
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+typedef uint8_t byte;
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_ptr(addr) (*(const void * const *)(addr))
+#define memcpy_P memcpy
+#define memcmp_P memcmp
+#endif
+
+//*** Some conversion factors
+#define FTM  0.3048        // feet to meters
+#define MTF  3.28084       // meters to feet
+#define NTK  1.852         // nautical mile to km
+#define KTN  0.5399569     // km to nautical mile
+//*** feet to meters as a ratio for the fixed point math
+#define FTM_MUL 3048L
+#define FTM_DIV 10000L
+
+//*** The NMEA defines in totl 82 characters including the starting 
+//*** characters $ or ! and the checksum character *, the checksum
+//*** AND last but not least the <CR><LF> chacters.
+//*** we define one more for the terminating '\0' character for char buffers
+#define NMEA_BUFFER_SIZE 82 // According NEA0183 specs the max char is 82
+#define NMEA_TERMINATOR "\r\n"
+
+//*** The maximum number of fields in an NMEA string
+//*** The number is based on the largest sentence MDA,
+//***  the Meteorological Composite sentence
+#define MAX_NMEA_FIELDS 21
+
+#define TALKER_ID "AO"
+//*** On my boat there is an ofsett of 0.2V between the battery monitor and what 
+//*** is measured by the Robertson Databox
+#define BATTERY_OFFSET 0.2 //Volts
+#define BATTERY_OFFSET_FIXED ((int32_t)(BATTERY_OFFSET*10+0.5)) // in 0.1 Volts
+//*** define NMEA tags to be used
+//*** make sure you know your Talker ID used in the sentences
+//*** In my case next to GP for navigation related sentences
+//*** II is used for Integrated Instruments and
+//*** PS is used for vendor specific tags like Stowe Marine
+//*** AO is used for my Andruino generated sentences
+
+/* for lab testing with an NMEA simulator tool
+#define _DBK "$SDDBK"   // Depth below keel
+#define _DBS "$SDDBS"   // Depth below surface
+#define _DBT "$SDDBT"   // Depth below transducer
+*/
+#define _DBK "$IIDBK"   // Depth below keel
+#define _DBS "$IIDBS"   // Depth below surface
+#define _DBT "$IIDBT"   // Depth below transducer
+#define _HDG "$IIHDG"   // Heading  Deviation & Variation
+#define _HDM "$IIHDM"   // Heading Magnetic
+#define _HDT "$IIHDT"  // Heading True
+#define _MWD "$IIMWD"  // Wind Direction & Speed
+#define _MTW "$IIMTW"  // Water Temperature
+/* for lab testing with an NMEA simulator tool
+#define _MWV "$WIMWV"  // Wind Speed and Angle
+*/
+#define _MWV "$IIMWV"  // Wind Speed and Angle
+#define _ROT "$IIROT"  // Rate of Turn
+#define _RPM "$IIRPM"  // Revolutions
+#define _RSA "$IIRSA"  // Rudder sensor angle
+#define _VDR "$IIVDR"  // Set and Drift
+#define _VHW "$IIVHW"  // Water Speed and Heading
+#define _VLW "$IIVLW"  //  Distance Traveled through Water
+#define _VTG "$IIVTG"  //  Track Made Good and Ground Speed
+#define _VWR "$IIVWR"  //  Relative Wind Speed and Angle
+#define _XDR "$IIXDR"  //  Cross Track Error  Dead Reckoning
+#define _XTE "$IIXTE"  //  Cross-Track Error  Measured
+#define _XTR "$IIXTR"  //  Cross Track Error  Dead Reckoning
+#define _ZDA "$IIZDA"  //  Time & Date - UTC, day, month, year and local time zone
+//*** Some specific GPS sentences
+#define _GLL "$GPGLL"   // Geographic Position  Latitude/Longitude
+#define _GGA "$GPGGA"   // GPS Fix Data. Time, Position and fix related data for a GPS receiver
+#define _GSA "$GPGSA"   // GPS DOP and active satellites
+#define _GSV "$GPGSV"   // Satellites in view
+#define _RMA "$GPRMA"  // Recommended Minimum Navigation Information
+#define _RMB "$GPRMB"  // Recommended Minimum Navigation Information
+#define _RMC "$GPRMC"  // Recommended Minimum Navigation Information
+
+//*** Some specific Robertson / Stowe Marine tags below
+#define _TON "$PSTON"  // Distance Nautical since reset
+#define _TOE "$PSTOE"  // Engine hours
+#define _TOB "$PSTOB"  // Battery voltage
+#define _TOD "$PSTOD"  // depth transducer below waterline in feet
+//*** Arduino generated TAGS
+#define _xDR "$" TALKER_ID "" "XDR" // Arduino Transducer measurement
+#define _dPT "$" TALKER_ID "" "DPT" // Arduino Transducer measurement
+#define _hDG "$" TALKER_ID "" "HDG" // Arduino Transducer measurement
+/* SPECIAL NOTE:
+  XDR - Transducer Measurement
+        1 2   3 4            n
+        | |   | |            |
+  $--XDR,a,x.x,a,c--c, ..... *hh<CR><LF>
+  Field Number:   1:Transducer Type
+                2:Measurement Data
+                3:Units of measurement
+                4:Name of transducer
+
+  There may be any number of quadruplets like this, each describing a sensor. The last field will be a checksum as usual.
+  Example:
+  $HCXDR,A,171,D,PITCH,A,-37,D,ROLL,G,367,,MAGX,G,2420,,MAGY,G,-8984,,MAGZ*41
+*/
+
+/*
+   Every tag defined above gets a small integer ID, so the tag of a sentence is
+   compared only once, when it is parsed, and all further decisions are a table
+   lookup or a switch on the ID. When you define a new tag, add it to NMEA_TAGS
+   as well; the compiler checks that all tags still hash to a unique slot.
+*/
+#define NMEA_TAGS(X) \
+  X(DBK) X(DBS) X(DBT) X(HDG) X(HDM) X(HDT) X(MWD) X(MTW) X(MWV) X(ROT) X(RPM) \
+  X(RSA) X(VDR) X(VHW) X(VLW) X(VTG) X(VWR) X(XDR) X(XTE) X(XTR) X(ZDA) \
+  X(GLL) X(GGA) X(GSA) X(GSV) X(RMA) X(RMB) X(RMC) \
+  X(TON) X(TOE) X(TOB) X(TOD) \
+  X(xDR) X(dPT) X(hDG)
+
+#define NMEA_TAG_ENUM(name) TAG_##name,
+enum nmea_tags { TAG_UNKNOWN, NMEA_TAGS(NMEA_TAG_ENUM) TAG_COUNT };
+
+#define NMEA_TAG_SIZE 7     // a tag like "$IIDBK" including the '\0'
+#define NMEA_TAG_SLOTS 128  // nr of slots in the tag hash table; a power of 2
+
+//*** Hash the talker and sentence ID (the 5 characters after the start delimiter)
+//*** into a slot of the tag hash table: h = (h ^ c) * 33 on 16 bits.
+//*** The multiplier and the shift are chosen so all tags above get their own slot.
+constexpr uint16_t nmeaTagHash(const char *tag, byte i, uint16_t h){
+  return ( i>=NMEA_TAG_SIZE-1 ? h : nmeaTagHash( tag, i+1, (uint16_t)( ( h ^ (byte)tag[i] ) * 33 ) ) );
+}
+
+constexpr byte nmeaTagSlot(const char *tag){
+  return ( nmeaTagHash( tag, 1, 0 ) >> 1 ) & ( NMEA_TAG_SLOTS-1 );
+}
+
+//*** the tag ID that owns a slot; evaluated by the compiler only
+#define NMEA_TAG_SLOT_OWNER(name) nmeaTagSlot(_##name)==slot ? TAG_##name :
+constexpr byte nmeaTagSlotOwner(byte slot){
+  return NMEA_TAGS(NMEA_TAG_SLOT_OWNER) TAG_UNKNOWN;
+}
+
+//*** every tag must have the right size and a slot of its own
+#define NMEA_TAG_PERFECT(name) && sizeof(_##name)==NMEA_TAG_SIZE && nmeaTagSlotOwner(nmeaTagSlot(_##name))==TAG_##name
+static_assert( true NMEA_TAGS(NMEA_TAG_PERFECT), "NMEA tags collide in nmeaTagSlot(); change the hash" );
+
+//*** the slot -> tag ID table in flash, generated by the compiler
+#define NMEA_TAG_SLOTS_4(s) nmeaTagSlotOwner(s), nmeaTagSlotOwner(s+1), nmeaTagSlotOwner(s+2), nmeaTagSlotOwner(s+3)
+#define NMEA_TAG_SLOTS_16(s) NMEA_TAG_SLOTS_4(s), NMEA_TAG_SLOTS_4(s+4), NMEA_TAG_SLOTS_4(s+8), NMEA_TAG_SLOTS_4(s+12)
+const byte nmeaTagSlots[NMEA_TAG_SLOTS] PROGMEM = {
+  NMEA_TAG_SLOTS_16(0), NMEA_TAG_SLOTS_16(16), NMEA_TAG_SLOTS_16(32), NMEA_TAG_SLOTS_16(48),
+  NMEA_TAG_SLOTS_16(64), NMEA_TAG_SLOTS_16(80), NMEA_TAG_SLOTS_16(96), NMEA_TAG_SLOTS_16(112)
+};
+
+//*** the tag of each ID in flash, to verify a hit in the slot table
+#define NMEA_TAG_NAME(name) _##name,
+const char nmeaTagNames[TAG_COUNT][NMEA_TAG_SIZE] PROGMEM = { "", NMEA_TAGS(NMEA_TAG_NAME) };
+
+//*** returns the ID of the tag of len characters or TAG_UNKNOWN
+inline byte nmeaTagId(const char *tag, byte len){
+  if( len!=NMEA_TAG_SIZE-1 ) return TAG_UNKNOWN;
+  byte id = pgm_read_byte( &nmeaTagSlots[ nmeaTagSlot( tag ) ] );
+  if( id!=TAG_UNKNOWN && memcmp_P( tag, nmeaTagNames[id], len )!=0 ) id = TAG_UNKNOWN;
+  return id;
+}
+
+/*
+   If there is some special treatment needed for some NMEA sentences then
+   add the their definitions to the NMEA_SPECIALTY definition
+   The pre-compiler concatenates string literals by using "" in between
+*/
+#define NMEA_SPECIALTY "" _DBK "" _TOB
+
+//*** NMEA_SPECIALTY is turned into a flag per tag ID by the compiler, so the
+//*** parser tests membership with a single table lookup, however many tags
+//*** need special treatment. A tag only matches on a tag boundary.
+constexpr bool nmeaTagEquals(const char *a, const char *b, byte i){
+  return ( i>=NMEA_TAG_SIZE-1 || ( a[i]==b[i] && nmeaTagEquals( a, b, i+1 ) ) );
+}
+
+constexpr bool nmeaTagInList(const char *list, const char *tag){
+  return ( list[0]!='\0' && ( nmeaTagEquals( list, tag, 0 ) || nmeaTagInList( list+NMEA_TAG_SIZE-1, tag ) ) );
+}
+
+#define NMEA_TAG_NAME_OF(name) id==TAG_##name ? _##name :
+constexpr const char *nmeaTagNameOf(byte id){
+  return NMEA_TAGS(NMEA_TAG_NAME_OF) "";
+}
+
+//*** true if every entry of the list is a tag in NMEA_TAGS
+constexpr bool nmeaTagListKnown(const char *list){
+  return ( list[0]=='\0' ||
+           ( nmeaTagEquals( list, nmeaTagNameOf( nmeaTagSlotOwner( nmeaTagSlot( list ) ) ), 0 ) &&
+             nmeaTagListKnown( list+NMEA_TAG_SIZE-1 ) ) );
+}
+
+//*** true if list, like NMEA_SPECIALTY, is a concatenation of tags listed in NMEA_TAGS
+#define NMEA_TAG_LIST_VALID(list) ( (sizeof(list)-1) % (NMEA_TAG_SIZE-1) == 0 && nmeaTagListKnown(list) )
+
+static_assert( NMEA_TAG_LIST_VALID(NMEA_SPECIALTY),
+               "NMEA_SPECIALTY must be a concatenation of tags listed in NMEA_TAGS" );
+
+/*
+   The conversion of a tag in NMEA_SPECIALTY is a rule in flash: a list of steps,
+   each adding one or more fields to the new sentence, closed by REWRITE_END.
+   The parser runs the steps over the field views of the received sentence and
+   adds the checksum. Numeric values are handled in fixed point with 1 decimal.
+     REWRITE_TAG(tag)                     the new tag, i.e. "$AODPT"
+     REWRITE_TALKER(id)                   the received tag with another talker ID, i.e. "AO"
+     REWRITE_COPY(field,count)            copy count fields from field on, 0 copies up to the last field;
+                                          fields that are not copied are dropped
+     REWRITE_UPPER(field)                 copy a field in upper case
+     REWRITE_SCALE(field,mul,div,add,unit) the field * mul / div + add when the next field
+                                          holds unit, or always if unit is NULL; else a copy
+     REWRITE_LITERAL(text)                a literal field
+   Like the parser always did, an empty field is copied as "0".
+*/
+enum rewrite_ops { RW_END, RW_TAG, RW_TALKER, RW_COPY, RW_UPPER, RW_SCALE, RW_LITERAL };
+
+typedef struct {
+  byte op;          // one of rewrite_ops
+  byte field;       // the field of the received sentence the step works on
+  byte count;       // RW_COPY: the nr of fields
+  int mul, div, add;
+  const char *text; // the tag, talker ID, unit or literal
+} RewriteStep;
+
+#define REWRITE_TAG(tag)                      { RW_TAG, 0, 0, 1, 1, 0, tag }
+#define REWRITE_TALKER(id)                    { RW_TALKER, 0, 0, 1, 1, 0, id }
+#define REWRITE_COPY(field,count)             { RW_COPY, field, count, 1, 1, 0, NULL }
+#define REWRITE_UPPER(field)                  { RW_UPPER, field, 1, 1, 1, 0, NULL }
+#define REWRITE_SCALE(field,mul,div,add,unit) { RW_SCALE, field, 1, mul, div, add, unit }
+#define REWRITE_LITERAL(text)                 { RW_LITERAL, 0, 0, 1, 1, 0, text }
+#define REWRITE_END                           { RW_END, 0, 0, 1, 1, 0, NULL }
+
+/* In my on-board Robertson data network some sentences
+   are not NMEA0183 compliant. So these sentences need
+   to be converted to compliant sentences
+*/
+
+//*** $IIDBK is not NMEA0183 compliant and needs conversion
+//*** a typical non standard DBK message I receive is
+//*** $IIDBK,A,0017.6,f,,,,
+//*** Char A can also be a V if invalid and should be removed.
+//*** Since DBK/DBS sentences are obsolete DPT is used, for TZ iBoat does not use DBT
+const RewriteStep rewriteDBK[] PROGMEM = {
+  REWRITE_TAG("$AODPT"),
+  REWRITE_SCALE(2, FTM_MUL, FTM_DIV, 0, "f"),  // depth in feet is converted to meters
+  REWRITE_LITERAL("0.0"),                      // the transducer offset
+  REWRITE_END
+};
+
+//*** below rule is for DBT
+// const RewriteStep rewriteDBK[] PROGMEM = {
+//   REWRITE_TAG("$AODBT"),
+//   REWRITE_COPY(2, 2),                        // depth in feet
+//   REWRITE_SCALE(2, FTM_MUL, FTM_DIV, 0, "f"),
+//   REWRITE_LITERAL("M"),
+//   REWRITE_LITERAL(""),                       // no depth in fathoms
+//   REWRITE_LITERAL(""),
+//   REWRITE_END
+// };
+
+//*** current Battery info is in a non NMEA0183 format
+//*** i.e. $PSTOB,13.2,V
+//*** will be converted to $AOXDR,U,13.2,V,BATT,*CS
+const RewriteStep rewriteTOB[] PROGMEM = {
+  REWRITE_TAG("$AOXDR"),
+  REWRITE_LITERAL("U"),                                 // the transducer unit
+  REWRITE_SCALE(1, 1, 1, BATTERY_OFFSET_FIXED, NULL),   // the actual measurement value
+  REWRITE_UPPER(2),                                     // unit of measure
+  REWRITE_LITERAL("BATT"),
+  REWRITE_END
+};
+
+//*** the rule of a tag ID
+constexpr const RewriteStep *rewriteRuleOf( byte id ){
+  return id==TAG_DBK ? rewriteDBK :
+         id==TAG_TOB ? rewriteTOB :
+         NULL;
+}
+
+#define NMEA_TAG_REWRITE(name) rewriteRuleOf(TAG_##name),
+const RewriteStep * const rewriteRules[TAG_COUNT] PROGMEM = { NULL, NMEA_TAGS(NMEA_TAG_REWRITE) };
+
+#define NMEA_TAG_REWRITE_SPECIALTY(name) && ( ( rewriteRuleOf(TAG_##name)!=NULL )==nmeaTagInList( NMEA_SPECIALTY, _##name ) )
+static_assert( true NMEA_TAGS(NMEA_TAG_REWRITE_SPECIALTY), "every tag in NMEA_SPECIALTY needs a rewrite rule and vice versa" );
+
+/*
+   The tags decoded into the vessel data, i.e. the values shown on the display pages.
+   Only these sentences and the ones in NMEA_SPECIALTY are split into fields. All
+   other sentences take the fast lane: once their tag is known the characters are
+   only checksummed and the sentence is forwarded as it was received.
+*/
+#define NMEA_DECODED "" _RMC "" _VHW "" _VWR "" _hDG "" _dPT "" _VLW "" _xDR "" _MTW
+
+static_assert( NMEA_TAG_LIST_VALID(NMEA_DECODED),
+               "NMEA_DECODED must be a concatenation of tags listed in NMEA_TAGS" );
+
+//*** flags per tag ID in flash
+#define TAG_SPECIALTY 0x01  // the tag is in NMEA_SPECIALTY
+#define TAG_DECODED 0x02    // the tag is in NMEA_DECODED
+#define TAG_FIELDS (TAG_SPECIALTY | TAG_DECODED) // the fields of the sentence are needed
+#define NMEA_TAG_FLAGS(name) ( ( nmeaTagInList( NMEA_SPECIALTY, _##name ) ? TAG_SPECIALTY : 0 ) | \
+                               ( nmeaTagInList( NMEA_DECODED, _##name ) ? TAG_DECODED : 0 ) ),
+const byte nmeaTagFlags[TAG_COUNT] PROGMEM = { 0, NMEA_TAGS(NMEA_TAG_FLAGS) };
+
+//*** true if the tag ID has one of the flags set
+inline bool nmeaTagHas(byte id, byte flags){
+  return ( ( pgm_read_byte( &nmeaTagFlags[id] ) & flags )!=0 );
+}
+
+/*
+   Decimal fixed point numbers
+   A value with d decimals is held in an int32_t as value * 10^d, i.e. "0017.6" with
+   1 decimal is 176. Numeric NMEA fields are converted, scaled and printed with
+   integer math only; no soft-float and no String on the AVR.
+*/
+#define FIXED_MAX 0x7FFFFFFFL // the largest fixed point value; a longer number saturates
+#define FIXED_TEXT_SIZE 13    // the longest fixedFormat() result, i.e. "-214748364.8", and its '\0'
+
+//*** convert the len characters of str to a fixed point number with the given decimals.
+//*** Like atof() it stops at the first character that does not belong to the number.
+//*** Extra decimals are rounded half away from zero. A number too large for an int32_t,
+//*** i.e. garbage on the line, gives +/-FIXED_MAX.
+inline int32_t fixedParse(const char *str, byte len, byte decimals)
+{
+  int32_t value = 0;
+  bool negative = false;
+  bool fraction = false;
+  bool roundUp = false;
+  byte i = 0;
+  byte d = 0;   // nr of decimals in value
+  while( i<len && str[i]==' ' ) i++;
+  if( i<len && ( str[i]=='-' || str[i]=='+' ) ) negative = ( str[i++]=='-' );
+  for( ; i<len; i++ )
+  {
+    char c = str[i];
+    if( c=='.' && !fraction ) fraction = true;
+    else if( c<'0' || c>'9' ) break;
+    else if( !fraction || d<decimals )
+    {
+      if( value>(FIXED_MAX-9)/10 ) return ( negative ? -FIXED_MAX : FIXED_MAX );
+      value = value*10 + (c-'0');
+      if( fraction ) d++;
+    } else {
+      roundUp = ( c>='5' );
+      break;
+    }
+  }
+  for( ; d<decimals; d++ )
+  {
+    if( value>FIXED_MAX/10 ) return ( negative ? -FIXED_MAX : FIXED_MAX );
+    value *= 10;
+  }
+  if( roundUp && value<FIXED_MAX ) value++;
+  return ( negative ? -value : value );
+}
+
+//*** a 64 bit intermediate limited to +/-FIXED_MAX
+inline int32_t fixedClamp(int64_t value)
+{
+  return ( value>FIXED_MAX ? FIXED_MAX : value<-FIXED_MAX ? -FIXED_MAX : (int32_t)value );
+}
+
+//*** multiply value by mul/div, rounded half away from zero. The product is taken in
+//*** 64 bits, so a large value scales correctly; a result beyond an int32_t saturates.
+inline int32_t fixedScale(int32_t value, int32_t mul, int32_t div)
+{
+  int64_t product = (int64_t)value*mul;
+  return fixedClamp( product<0 ? ( product-div/2 )/div : ( product+div/2 )/div );
+}
+
+//*** a + b, saturated at +/-FIXED_MAX
+inline int32_t fixedAdd(int32_t a, int32_t b)
+{
+  return fixedClamp( (int64_t)a+b );
+}
+
+//*** true if the number in the len characters of str, times mul/div plus add tenths,
+//*** is below 0 before it is rounded to 1 decimal. dtostrf() prints such a value as
+//*** "-0.0" when it rounds to 0, so the fixed point result must keep the sign too.
+//*** Only needed for a result of 0, which is less than 1 from 0 before rounding.
+inline bool fixedBelowZero(const char *str, byte len, int32_t mul, int32_t div, int32_t add)
+{
+  int64_t exact = (int64_t)fixedParse( str, len, 6 )*mul + (int64_t)add*100000L*div;
+  if( exact!=0 ) return ( exact<0 );
+  //*** -0 times anything is still -0, but -0 plus an offset is 0
+  while( len>0 && *str==' ' ) { str++; len--; }
+  return ( add==0 && len>0 && *str=='-' );
+}
+
+//*** print a fixed point number right aligned in width characters into buf, the same
+//*** way dtostrf() does, and return buf. buf needs room for FIXED_TEXT_SIZE characters
+//*** when width is at most FIXED_TEXT_SIZE-1 and decimals at most 9. With minus a
+//*** value of 0 is printed as "-0", like dtostrf() does for a small negative number.
+inline char *fixedFormat(char *buf, int32_t value, byte decimals, byte width, bool minus=false)
+{
+  char digits[12];
+  byte n = 0;
+  bool negative = ( value<0 || ( value==0 && minus ) );
+  uint32_t v = ( negative ? 0-(uint32_t)value : (uint32_t)value );
+  //*** the digits in reverse order; at least one before the decimal point
+  do {
+    digits[n++] = '0' + v%10;
+    v /= 10;
+  } while( v>0 || n<=decimals );
+  byte len = n + ( decimals>0 ? 1 : 0 ) + ( negative ? 1 : 0 );
+  byte pos = 0;
+  while( pos+len < width ) buf[pos++] = ' ';
+  if( negative ) buf[pos++] = '-';
+  while( n>0 )
+  {
+    if( n==decimals ) buf[pos++] = '.';
+    buf[pos++] = digits[--n];
+  }
+  buf[pos] = '\0';
+  return buf;
+}
+
+//*** the value of a hexadecimal digit in either case, or -1 if c is no hex digit
+inline int8_t hexValue(char c)
+{
+  if( c>='0' && c<='9' ) return c-'0';
+  if( c>='A' && c<='F' ) return c-'A'+10;
+  if( c>='a' && c<='f' ) return c-'a'+10;
+  return -1;
+}
+
+//*** The sentence buffer holds the longest sentence we accept (without <CR><LF>),
+//*** room for a checksum we may have to append, the <CR><LF> and the '\0'
+#define NMEA_MAX_SENTENCE (NMEA_BUFFER_SIZE-2)
+#define NMEA_SENTENCE_SIZE (NMEA_MAX_SENTENCE+3+2+1)
+
+//*** A structure to hold the NMEA data
+//*** The sentence is stored only once as a char array. The fields are views into
+//*** that array: fieldIndex[i] is the offset of the 1st character of field i and
+//*** fieldIndex[nrOfFields] is one past the end of the last field, so a field always
+//*** runs up to the character before the next index. No String objects are used, so
+//*** parsing a sentence never touches the heap.
+typedef struct NMEAData {
+  char sentence[NMEA_SENTENCE_SIZE]={0};
+  byte length=0;          // nr of characters in sentence
+  byte nrOfFields=0;
+  byte fieldIndex[MAX_NMEA_FIELDS+1]={0};
+  byte checksumIndex=0;   // position of the '*' or 0 if there is no checksum
+  byte crc=0;             // running XOR of the characters between the start delimiter and the '*'
+  byte tagId=TAG_UNKNOWN; // ID of the tag in field 0, set by the parser
+  bool fastLane=false;    // only the tag is indexed; the sentence is forwarded as is
+
+  //*** clears the sentence and the field views
+  void clear(){
+    sentence[0]='\0';
+    length=0;
+    nrOfFields=0;
+    fieldIndex[0]=0;
+    checksumIndex=0;
+    crc=0;
+    tagId=TAG_UNKNOWN;
+    fastLane=false;
+  }
+
+  //*** pointer to the 1st character of field i; the field is NOT '\0' terminated!
+  const char *field(byte i) const {
+    return ( i<nrOfFields ? sentence+fieldIndex[i] : "" );
+  }
+
+  //*** nr of characters in field i
+  byte fieldLength(byte i) const {
+    return ( i<nrOfFields ? fieldIndex[i+1]-fieldIndex[i]-1 : 0 );
+  }
+
+  //*** true if field i holds exactly the string str
+  bool fieldEquals(byte i, const char *str) const {
+    byte len = fieldLength(i);
+    return ( strlen(str)==len && strncmp( field(i), str, len)==0 );
+  }
+
+  //*** the numeric value of field i as a fixed point number with the given decimals
+  int32_t fieldToFixed(byte i, byte decimals) const {
+    return fixedParse( field(i), fieldLength(i), decimals );
+  }
+
+  //*** true if the sentence has no checksum or the received checksum matches the crc.
+  //*** The checksum must be exactly 2 hex digits and end the sentence.
+  bool checksumOk() const {
+    if( checksumIndex==0 ) return true;
+    if( length != checksumIndex+3 ) return false;
+    int8_t hi = hexValue( sentence[checksumIndex+1] );
+    int8_t lo = hexValue( sentence[checksumIndex+2] );
+    return ( hi>=0 && lo>=0 && ( (hi<<4) | lo )==crc );
+  }
+
+  //*** append a field to the sentence and record its view
+  //*** returns false if the sentence or the field views are full
+  bool addField(const char *str, byte len){
+    if( nrOfFields>=MAX_NMEA_FIELDS || length+len+1 > NMEA_MAX_SENTENCE ) return false;
+    if( nrOfFields>0 ){
+      sentence[length++]=',';
+      crc ^= ',';
+    }
+    fieldIndex[nrOfFields++]=length;
+    for( byte i=0; i<len; i++ ){
+      if( length>0 ) crc ^= str[i];
+      sentence[length++]=str[i];
+    }
+    fieldIndex[nrOfFields]=length+1;
+    sentence[length]='\0';
+    return true;
+  }
+
+  bool addField(const char *str){
+    return addField( str, strlen(str) );
+  }
+
+  //*** add the next character of an incoming sentence, starting with the start delimiter.
+  //*** The field views, the running checksum and the position of the '*' are kept
+  //*** up to date with every character, so a complete sentence is indexed as soon as
+  //*** its last character arrives. When there are more fields than MAX_NMEA_FIELDS
+  //*** the remainder of the sentence is kept in the last field.
+  //*** The tag is identified at the first ','. If its fields are not needed the
+  //*** sentence takes the fast lane and only the tag is indexed.
+  //*** returns false if the sentence does not fit
+  bool addChar(char c){
+    if( length>=NMEA_MAX_SENTENCE ) return false;
+    if( length==0 ){
+      nrOfFields=1;
+      fieldIndex[0]=0;
+    }
+    if( checksumIndex==0 ){
+      if( c=='*' && length>0 ){
+        checksumIndex=length;
+        if( !fastLane ) fieldIndex[nrOfFields]=length+1;
+      } else {
+        if( length>0 ) crc ^= c;
+        if( !fastLane ){
+          if( c==',' && nrOfFields==1 ){
+            tagId = nmeaTagId( sentence, length );
+            fastLane = !nmeaTagHas( tagId, TAG_FIELDS );
+          }
+          if( !fastLane ){
+            if( c==',' && nrOfFields<MAX_NMEA_FIELDS ) fieldIndex[nrOfFields++]=length+1;
+            fieldIndex[nrOfFields]=length+2;
+          }
+        }
+      }
+    }
+    sentence[length++]=c;
+    sentence[length]='\0';
+    return true;
+  }
+
+  //*** copy only the used part of the sentence and the field views to dest
+  void copyTo(NMEAData &dest) const {
+    memcpy( dest.sentence, sentence, length+1 );
+    memcpy( dest.fieldIndex, fieldIndex, nrOfFields+1 );
+    dest.length=length;
+    dest.nrOfFields=nrOfFields;
+    dest.checksumIndex=checksumIndex;
+    dest.crc=crc;
+    dest.tagId=tagId;
+    dest.fastLane=fastLane;
+  }
+
+  //*** append a string, i.e. the checksum or the terminator, if it fits
+  void append(const char *str){
+    byte len = strlen(str);
+    if( length+len < NMEA_SENTENCE_SIZE ){
+      memcpy( sentence+length, str, len+1);
+      length += len;
+    }
+  }
+
+}NMEAData ;
+
+//*** the reasons to drop an incoming sentence; DROP_LINE is a framing or parity error on
+//*** the UART, DROP_OVERRUN a character the UART lost (counted even between sentences),
+//*** DROP_RINGFULL a character lost because the receive ring of the listener was full
+enum nmea_drops { DROP_CHECKSUM, DROP_OVERLONG, DROP_UNTERMINATED, DROP_LINE, DROP_OVERRUN, DROP_RINGFULL, DROP_COUNT };
+
+/*
+ * Copy field i of nmeaIn as a new field to nmeaOut. Like the parser always did
+ * an empty field is copied as "0"
+ */
+inline void nmeaCopyField( NMEAData &nmeaOut, const NMEAData &nmeaIn, byte i )
+{
+  if( nmeaIn.fieldLength(i)>0 ) nmeaOut.addField( nmeaIn.field(i), nmeaIn.fieldLength(i) );
+  else nmeaOut.addField( "0" );
+}
+
+// calculate checksum function (thanks to https://mechinations.wordpress.com)
+inline void nmeaChecksum( NMEAData &nmea )
+{
+  const char hex[] = "0123456789abcdef";
+  char cs[4] = "*00";
+  //*** the XOR of the characters is kept up to date while the sentence is built
+  cs[1] = hex[ nmea.crc>>4 ];
+  cs[2] = hex[ nmea.crc & 0x0F ];
+  nmea.checksumIndex = nmea.length;
+  nmea.append( cs );
+}
+
+/*
+  Rebuild the sentences in NMEA_SPECIALTY from nmeaIn into nmeaOut by running
+  the steps of the rewrite rule of the tag
+  returns false if there is no rule for the tag
+*/
+inline bool nmeaRewrite( const NMEAData &nmeaIn, NMEAData &nmeaOut )
+{
+  char value[FIXED_TEXT_SIZE];  // holds a converted numeric value or a new tag
+  RewriteStep step;
+  
+  const RewriteStep *rule = (const RewriteStep *)pgm_read_ptr( &rewriteRules[ nmeaIn.tagId ] );
+  if( rule==NULL ) return false;
+  nmeaOut.clear();
+  for( ;; rule++ )
+  {
+    memcpy_P( &step, rule, sizeof(step) );
+    switch( step.op )
+    {
+      case RW_END:
+        nmeaChecksum( nmeaOut );
+        return true;
+
+      case RW_TAG:
+      case RW_LITERAL:
+        nmeaOut.addField( step.text );
+        break;
+
+      case RW_TALKER:
+        //*** start delimiter, the new talker ID and the received sentence ID
+        if( nmeaIn.fieldLength(0)!=NMEA_TAG_SIZE-1 ) return false;
+        memcpy( value, nmeaIn.field(0), NMEA_TAG_SIZE-1 );
+        value[1] = step.text[0];
+        value[2] = step.text[1];
+        nmeaOut.addField( value, NMEA_TAG_SIZE-1 );
+        break;
+
+      case RW_COPY:
+      {
+        byte last = ( step.count==0 ? nmeaIn.nrOfFields : step.field+step.count );
+        for( byte i=step.field; i<last; i++ ) nmeaCopyField( nmeaOut, nmeaIn, i );
+        break;
+      }
+
+      case RW_UPPER:
+        nmeaCopyField( nmeaOut, nmeaIn, step.field );
+        for( byte i=nmeaOut.fieldIndex[ nmeaOut.nrOfFields-1 ]; i<nmeaOut.length; i++ )
+        {
+          char c = toupper( nmeaOut.sentence[i] );
+          nmeaOut.crc ^= nmeaOut.sentence[i] ^ c; // keep the running checksum in line
+          nmeaOut.sentence[i] = c;
+        }
+        break;
+
+      case RW_SCALE:
+        if( step.text==NULL || nmeaIn.fieldEquals( step.field+1, step.text ) )
+        {
+          int32_t fixed = fixedAdd( fixedScale( nmeaIn.fieldToFixed( step.field, 1 ), step.mul, step.div ), step.add );
+          bool minus = ( fixed==0 && fixedBelowZero( nmeaIn.field( step.field ), nmeaIn.fieldLength( step.field ),
+                                                     step.mul, step.div, step.add ) );
+          nmeaOut.addField( fixedFormat( value, fixed, 1, 3, minus ) );
+        } else nmeaCopyField( nmeaOut, nmeaIn, step.field );
+        break;
+
+      default:
+        return false;
+    }
+  }
+}
+
+/*
+   Check the received checksum of a sentence of which the field views are complete
+   and make sure its tag ID is known; cheap, the crc and the tag are normally
+   resolved while the characters arrive.
+   returns false if the received checksum is wrong; the sentence must be dropped
+*/
+inline bool nmeaIdentify( NMEAData &nmea )
+{
+  //*** line noise must not reach the plotter
+  if( !nmea.checksumOk() ) return false;
+  //*** the tag is normally identified at the first ','
+  if( nmea.tagId==TAG_UNKNOWN ) nmea.tagId = nmeaTagId( nmea.field(0), nmea.fieldLength(0) );
+  return true;
+}
+
+/*
+   Finish a sentence that passed nmeaIdentify() the way the multiplexer forwards it:
+   convert it if it is in NMEA_SPECIALTY or add a checksum if it has none, and
+   terminate it.
+*/
+inline void nmeaFinish( NMEAData &nmea )
+{
+  NMEAData nmeaOut;
+  //*** fast lane sentences are not in NMEA_SPECIALTY and go straight to the checksum test
+  if ( !nmea.fastLane && nmeaTagHas( nmea.tagId, TAG_SPECIALTY ) && nmeaRewrite( nmea, nmeaOut ) )
+  {
+    nmeaOut.copyTo( nmea );
+    nmea.tagId = nmeaTagId( nmea.field(0), nmea.fieldLength(0) );
+  } else if( nmea.checksumIndex==0 )  //Check for checksum in sentence
+  {
+    nmeaChecksum( nmea );
+  }
+  nmea.append( NMEA_TERMINATOR );
+}
+
+/*
+   Identify and finish a sentence of which the field views are complete, see
+   nmeaIdentify() and nmeaFinish().
+   returns false if the received checksum is wrong; the sentence must be dropped
+*/
+inline bool nmeaConvert( NMEAData &nmea )
+{
+  if( !nmeaIdentify( nmea ) ) return false;
+  nmeaFinish( nmea );
+  return true;
+}
+
+#endif
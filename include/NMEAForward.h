@@ -0,0 +1,204 @@
+/*
+  Project:  Yazz_Multiplexer.ino, Copyright 2020, Roy Wassili
+  File:     NMEAForward.h
+  Purpose:  The rules that decide whether a converted sentence is forwarded now:
+            the token buckets of RATE_LIMITS and the change cache of CHANGE_ONLY.
+            Like NMEACore.h it needs no hardware but the millisecond clock, so the
+            host tests in test/ run the same code as the multiplexer.
+            The includer defines RATE_LIMITS, RATE_BURST, CHANGE_ONLY and
+            CHANGE_KEEPALIVE first; src/main.cpp has them with the other settings.
+*/
+#ifndef NMEAFORWARD_H
+#define NMEAFORWARD_H
+
+#include <NMEACore.h>
+
+#ifndef ARDUINO
+//*** a host build; the host program provides the clock
+unsigned long millis();
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#endif
+
+#if !defined(RATE_LIMITS) || !defined(RATE_BURST) || !defined(CHANGE_ONLY) || !defined(CHANGE_KEEPALIVE)
+#error "define RATE_LIMITS, RATE_BURST, CHANGE_ONLY and CHANGE_KEEPALIVE before including NMEAForward.h"
+#endif
+
+/*
+   Purpose:  Per tag rate limiting between the parser and the queue
+            - Every tag in RATE_LIMITS has a token bucket. A sentence that finds no
+              token is held back in the one slot of its bucket, replacing the one held
+              before, and is forwarded by release() when the next token is due. So the
+              newest value is always forwarded, at most one interval late, and a
+              replaced sentence is counted as limited.
+            - A token is only used by sent(), once the sentence is queued. A sentence
+              the queue sheds leaves the token for the next one of its tag.
+            - The bucket is kept as the time its next token is due (the theoretical
+              arrival time), which needs no division: a few compares and adds per
+              sentence. Tags without a limit cost 1 read from flash.
+*/
+#define RATE_BUCKET_ENUM(name,ms) RATE_##name,
+enum rate_buckets { RATE_LIMITS(RATE_BUCKET_ENUM) RATE_BUCKETS, RATE_NONE=0xFF };
+
+//*** the interval of every bucket in flash
+#define RATE_INTERVAL(name,ms) ms,
+const uint16_t rateIntervals[RATE_BUCKETS+1] PROGMEM = { RATE_LIMITS(RATE_INTERVAL) 0 };
+
+//*** the bucket per tag ID in flash
+#define RATE_BUCKET_OF(name,ms) id==TAG_##name ? RATE_##name :
+constexpr byte rateBucketOf(byte id){
+  return RATE_LIMITS(RATE_BUCKET_OF) RATE_NONE;
+}
+#define NMEA_TAG_BUCKET(name) rateBucketOf(TAG_##name),
+const byte nmeaTagBucket[TAG_COUNT] PROGMEM = { RATE_NONE, NMEA_TAGS(NMEA_TAG_BUCKET) };
+
+static_assert( RATE_BURST>=1, "RATE_BURST must be 1 or more" );
+
+class NMEARateLimiter
+ {
+  public:
+  bool admit( const NMEAData &_nmea ); // true if the sentence may be forwarded now, else it is held
+  NMEAData *release();          // a held sentence of which the token is due, or NULL
+  void sent( const NMEAData &_nmea ); // the sentence is queued; use the token of its tag
+  unsigned long getLimited();   // nr of sentences replaced by a newer one of their tag
+
+  private:
+  bool hasToken( byte bucket ); // true if the bucket has a token left
+  unsigned long due[RATE_BUCKETS+1]={0}; // the time in ms the next token of a bucket is due
+  NMEAData held[RATE_BUCKETS];  // the newest sentence per bucket that found no token
+  bool holding[RATE_BUCKETS+1]={false};
+  unsigned long limited=0;
+ };
+
+  inline bool NMEARateLimiter::hasToken( byte bucket )
+  {
+    unsigned long interval = pgm_read_word( &rateIntervals[ bucket ] );
+    //*** no token left while the bucket is due more than RATE_BURST-1 intervals ahead
+    return ( (long)( millis()+(RATE_BURST-1)*interval-due[ bucket ] )>=0 );
+  }
+
+  inline bool NMEARateLimiter::admit( const NMEAData &_nmea )
+  {
+    byte bucket = pgm_read_byte( &nmeaTagBucket[ _nmea.tagId ] );
+    if( bucket==RATE_NONE ) return true;
+
+    //*** a held sentence is older than this one, so it is lost either way
+    if( holding[ bucket ] ) limited++;
+    if( hasToken( bucket ) )
+    {
+      holding[ bucket ] = false;
+      return true;
+    }
+    _nmea.copyTo( held[ bucket ] );
+    holding[ bucket ] = true;
+    return false;
+  }
+
+  //*** the sentence is no longer held, also when the queue sheds it, and stays valid
+  //*** until the next admit() of its tag
+  inline NMEAData *NMEARateLimiter::release()
+  {
+    for( byte bucket=0; bucket<RATE_BUCKETS; bucket++ )
+    {
+      if( holding[ bucket ] && hasToken( bucket ) )
+      {
+        holding[ bucket ] = false;
+        return &held[ bucket ];
+      }
+    }
+    return NULL;
+  }
+
+  inline void NMEARateLimiter::sent( const NMEAData &_nmea )
+  {
+    byte bucket = pgm_read_byte( &nmeaTagBucket[ _nmea.tagId ] );
+    if( bucket==RATE_NONE ) return;
+
+    unsigned long now = millis();
+    unsigned long interval = pgm_read_word( &rateIntervals[ bucket ] );
+    //*** an idle bucket fills up to RATE_BURST tokens, but not beyond
+    due[ bucket ] = ( (long)( now-due[ bucket ] )>0 ? now : due[ bucket ] )+interval;
+  }
+
+  inline unsigned long NMEARateLimiter::getLimited()
+  {
+    return limited;
+  }
+
+/*
+   Purpose:  Change only forwarding of the tags in CHANGE_ONLY
+            - Every tag in CHANGE_ONLY has a slot with a 16 bit hash of the last
+              sentence forwarded and the time it was forwarded. A converted sentence
+              with the same hash is suppressed until CHANGE_KEEPALIVE ms have passed.
+            - changed() only tests; sent() records a sentence once it is queued, so
+              a changed value the queue sheds is not taken for sent.
+            - A suppressed sentence is not queued, so it costs no talker time and
+              no display redraw. Tags not listed cost 1 read from flash.
+*/
+#define CHANGE_SLOT_ENUM(name) CHANGE_##name,
+enum change_slots { CHANGE_ONLY(CHANGE_SLOT_ENUM) CHANGE_SLOTS, CHANGE_NONE=0xFF };
+
+//*** the slot per tag ID in flash
+#define CHANGE_SLOT_OF(name) id==TAG_##name ? CHANGE_##name :
+constexpr byte changeSlotOf(byte id){
+  return CHANGE_ONLY(CHANGE_SLOT_OF) CHANGE_NONE;
+}
+#define NMEA_TAG_CHANGE_SLOT(name) changeSlotOf(TAG_##name),
+const byte nmeaTagChangeSlot[TAG_COUNT] PROGMEM = { CHANGE_NONE, NMEA_TAGS(NMEA_TAG_CHANGE_SLOT) };
+
+class NMEAChangeCache
+ {
+  public:
+  bool changed( const NMEAData &_nmea ); // true if the sentence must be forwarded
+  void sent( const NMEAData &_nmea );    // the sentence is queued; it is the last one sent
+  unsigned long getSuppressed();         // nr of repeated sentences not forwarded
+
+  private:
+  uint16_t hash( const NMEAData &_nmea );
+  typedef struct {
+    uint16_t hash;            // of the last sentence forwarded
+    unsigned long sent;       // the time in ms it was forwarded
+    bool valid;               // a sentence was forwarded
+  } ChangeSlot;
+  ChangeSlot slots[CHANGE_SLOTS+1]={};
+  unsigned long suppressed=0;
+ };
+
+  //*** a 16 bit rotate and xor hash; the checksum and terminator are part of it
+  inline uint16_t NMEAChangeCache::hash( const NMEAData &_nmea )
+  {
+    uint16_t h=0;
+    for( byte i=0; i<_nmea.length; i++ ) h = (uint16_t)( ( h<<5 ) | ( h>>11 ) ) ^ (byte)_nmea.sentence[i];
+    return h;
+  }
+
+  inline bool NMEAChangeCache::changed( const NMEAData &_nmea )
+  {
+    byte slot = pgm_read_byte( &nmeaTagChangeSlot[ _nmea.tagId ] );
+    if( slot==CHANGE_NONE ) return true;
+
+    ChangeSlot &last = slots[ slot ];
+    if( last.valid && last.hash==hash( _nmea ) && millis()-last.sent<CHANGE_KEEPALIVE )
+    {
+      suppressed++;
+      return false;
+    }
+    return true;
+  }
+
+  inline void NMEAChangeCache::sent( const NMEAData &_nmea )
+  {
+    byte slot = pgm_read_byte( &nmeaTagChangeSlot[ _nmea.tagId ] );
+    if( slot==CHANGE_NONE ) return;
+
+    ChangeSlot &last = slots[ slot ];
+    last.hash = hash( _nmea );
+    last.sent = millis();
+    last.valid = true;
+  }
+
+  inline unsigned long NMEAChangeCache::getSuppressed()
+  {
+    return suppressed;
+  }
+
+#endif
@@ -0,0 +1,164 @@
+/*
+  Project:  Yazz_Multiplexer.ino, Copyright 2020, Roy Wassili
+  File:     VesselData.h
+  Purpose:  The vessel data model: the quantities the display shows, decoded once
+            per sentence from the tags in NMEA_DECODED, with the time they were
+            decoded. Like NMEACore.h it needs no hardware but the millisecond clock,
+            so the host tests in test/ run the same decoders as the multiplexer.
+            The includer defines VESSEL_STALE first; src/main.cpp has it with the
+            other settings.
+*/
+#ifndef VESSELDATA_H
+#define VESSELDATA_H
+
+#include <NMEACore.h>
+
+#ifndef ARDUINO
+//*** a host build; the host program provides the clock
+unsigned long millis();
+#endif
+
+#ifndef VESSEL_STALE
+#error "define VESSEL_STALE before including VesselData.h"
+#endif
+
+//*** the quantities of the vessel data
+enum vessel_values { VESSEL_SOG, VESSEL_COG, VESSEL_STW, VESSEL_AWS, VESSEL_AWA, VESSEL_DEPTH,
+                     VESSEL_HEADING, VESSEL_LOG, VESSEL_TRIP, VESSEL_BATTERY, VESSEL_WATER_TEMP,
+                     VESSEL_COUNT };
+
+/*
+  The vessel data: the latest value of each quantity as a fixed point number with 1
+  decimal and the millis() at which it was decoded. The parser decodes a sentence
+  into it once (see decode()); the display and any other consumer read a value in
+  O(1) and can tell a fresh value from a stale one.
+  Speeds are in knots, angles in degrees, the depth in meters, the log and trip in NM,
+  the battery in volts and the water temperature in degrees Celsius. An AWA to port
+  is negative.
+*/
+class VesselData
+{
+  public:
+    void decode( const NMEAData &nmea );   // set the quantities a converted sentence carries
+    void set( byte quantity, long value ); // store a decoded value, stamped with millis()
+    bool isKnown( byte quantity );         // true if the quantity was ever decoded
+    bool isStale( byte quantity );         // true if not decoded in the last VESSEL_STALE ms
+    long get( byte quantity );             // the latest value
+    unsigned long getStamp( byte quantity ); // the millis() at which it was decoded
+
+  private:
+    long value[VESSEL_COUNT]={0};
+    unsigned long stamp[VESSEL_COUNT]={0};
+    uint16_t known=0;     // a bit per quantity that was decoded
+};
+static_assert( VESSEL_COUNT<=16, "VesselData::known has a bit per quantity" );
+
+inline void VesselData::set( byte quantity, long v )
+{
+  value[ quantity ] = v;
+  stamp[ quantity ] = millis();
+  known |= ( 1U<<quantity );
+}
+
+inline bool VesselData::isKnown( byte quantity )
+{
+  return ( known & ( 1U<<quantity ) )!=0;
+}
+
+inline bool VesselData::isStale( byte quantity )
+{
+  return !isKnown( quantity ) || millis()-stamp[ quantity ]>=VESSEL_STALE;
+}
+
+inline long VesselData::get( byte quantity )
+{
+  return value[ quantity ];
+}
+
+inline unsigned long VesselData::getStamp( byte quantity )
+{
+  return stamp[ quantity ];
+}
+
+/*
+ * Vessel data decoders; one per tag in NMEA_DECODED. Each decoder reads the fields
+ * of the sentence once and sets the quantities it carries. An empty field or a value
+ * out of range leaves the quantity as it was, so it turns stale.
+ */
+typedef void (*NMEADecoder)( VesselData &vessel, const NMEAData &nmea );
+
+//*** set a quantity from field i if the field is not empty and the value below the limit
+inline void decodeField( VesselData &vessel, const NMEAData &nmea, byte i, byte quantity, long limit ){
+  if( nmea.fieldLength(i)==0 ) return;
+  long tmpVal=nmea.fieldToFixed(i, 1);
+  if( tmpVal<limit ) vessel.set( quantity, tmpVal );
+}
+
+// speeds are checked for values <100 (1000 in 0.1 kts); Higher is non existant
+inline void decodeRMC( VesselData &vessel, const NMEAData &nmea ){
+  decodeField( vessel, nmea, 7, VESSEL_SOG, 1000 );
+  decodeField( vessel, nmea, 8, VESSEL_COG, 3600 );
+}
+
+inline void decodeVHW( VesselData &vessel, const NMEAData &nmea ){
+  decodeField( vessel, nmea, 5, VESSEL_STW, 1000 );
+}
+
+inline void decodeVWR( VesselData &vessel, const NMEAData &nmea ){
+  decodeField( vessel, nmea, 3, VESSEL_AWS, 1000 );
+  long tmpVal=nmea.fieldToFixed(1, 1);
+  if( nmea.fieldLength(1)==0 || tmpVal>=3600 ) return;
+  if( nmea.fieldEquals(2, "R") ) vessel.set( VESSEL_AWA, tmpVal );
+  else if( nmea.fieldEquals(2, "L") ) vessel.set( VESSEL_AWA, -tmpVal );
+}
+
+inline void decodeHDG( VesselData &vessel, const NMEAData &nmea ){
+  decodeField( vessel, nmea, 1, VESSEL_HEADING, 3600 );
+}
+
+inline void decodeDPT( VesselData &vessel, const NMEAData &nmea ){
+  decodeField( vessel, nmea, 1, VESSEL_DEPTH, 100000 );
+}
+
+inline void decodeVLW( VesselData &vessel, const NMEAData &nmea ){
+  decodeField( vessel, nmea, 1, VESSEL_LOG, 1000000 );
+  decodeField( vessel, nmea, 3, VESSEL_TRIP, 1000000 );
+}
+
+// Voltage an Temperature are checked <100; Higher is non exsitant.
+inline void decodeXDR( VesselData &vessel, const NMEAData &nmea ){
+  if( nmea.fieldEquals(4, "BATT") ) decodeField( vessel, nmea, 2, VESSEL_BATTERY, 1000 );
+}
+
+inline void decodeMTW( VesselData &vessel, const NMEAData &nmea ){
+  decodeField( vessel, nmea, 1, VESSEL_WATER_TEMP, 1000 );
+}
+
+//*** the decoder of a tag ID; evaluated by the compiler only
+constexpr NMEADecoder vesselDecoderOf( byte id ){
+  return id==TAG_RMC ? decodeRMC :
+         id==TAG_VHW ? decodeVHW :
+         id==TAG_VWR ? decodeVWR :
+         id==TAG_hDG ? decodeHDG :
+         id==TAG_dPT ? decodeDPT :
+         id==TAG_VLW ? decodeVLW :
+         id==TAG_xDR ? decodeXDR :
+         id==TAG_MTW ? decodeMTW :
+         (NMEADecoder)NULL;
+}
+
+//*** the tag ID -> decoder table in flash
+#define NMEA_TAG_DECODER(name) vesselDecoderOf(TAG_##name),
+const NMEADecoder vesselDecoders[TAG_COUNT] PROGMEM = { NULL, NMEA_TAGS(NMEA_TAG_DECODER) };
+
+//*** the fields of a tag must be indexed to be decoded, so it has a decoder if and only if it is in NMEA_DECODED
+#define NMEA_TAG_DECODER_DECODED(name) && ( ( vesselDecoderOf(TAG_##name)!=NULL )==nmeaTagInList( NMEA_DECODED, _##name ) )
+static_assert( true NMEA_TAGS(NMEA_TAG_DECODER_DECODED), "every tag in NMEA_DECODED needs a decoder and vice versa" );
+
+inline void VesselData::decode( const NMEAData &nmea )
+{
+  NMEADecoder decoder = (NMEADecoder)pgm_read_ptr( &vesselDecoders[ nmea.tagId ] );
+  if( decoder!=NULL ) decoder( *this, nmea );
+}
+
+#endif
@@ -20,6 +20,7 @@ MIT License
 */
 
 #include "LCDWIKI_font.c"
+#include "LCDWIKI_digits.c"
 #include "LCDWIKI_GUI.h"
 
 #define swap(a, b) { int16_t t = a; a = b; b = t; }
@@ -558,6 +559,13 @@ void LCDWIKI_GUI::Draw_Char(int16_t x, int16_t y, uint8_t c, uint16_t color,uint
   	{
 		c++; 
   	}
+	//opaque and on screen: one address window for the whole cell
+	if(!mode && (bg != color) && (size <= DRAW_CHAR_SPAN_SIZE) && (x >= 0) && (y >= 0) &&
+	   ((x + 6 * size) <= Get_Width()) && ((y + 8 * size) <= Get_Height()))
+	{
+		Draw_Char_Span(x, y, c, color, bg, size);
+		return;
+	}
 	for (int8_t i=0; i<6; i++) 
 	{
     	uint8_t line;
@@ -641,6 +649,98 @@ size_t LCDWIKI_GUI::Print(uint8_t *st, int16_t x, int16_t y)
 	return n;
 }
 
+//draw an opaque char in one address window: each font row is expanded into a
+//span of 6*size pixels once and pushed size times, top to bottom
+void LCDWIKI_GUI::Draw_Char_Span(int16_t x, int16_t y, uint8_t c, uint16_t color,uint16_t bg, uint8_t size)
+{
+	uint8_t lines[6];
+	uint16_t span[6 * DRAW_CHAR_SPAN_SIZE];
+	bool first = true;
+	for (int8_t i=0; i<5; i++) 
+	{
+		lines[i] = pgm_read_byte(lcd_font+(c*5)+i);
+	}
+	lines[5] = 0x0;
+	Set_Addr_Window(x, y, x + 6 * size - 1, y + 8 * size - 1);
+	for (int8_t j = 0; j<8; j++) 
+	{
+		uint16_t *p = span;
+		for (int8_t i=0; i<6; i++) 
+		{
+			uint16_t pixel = (lines[i] & (1 << j)) ? color : bg;
+			for (uint8_t k = 0; k < size; k++)
+			{
+				*p++ = pixel;
+			}
+		}
+		for (uint8_t k = 0; k < size; k++)
+		{
+			Push_Any_Color(span, 6 * size, first, 0);
+			first = false;
+		}
+	}
+}
+
+//draw a large digit in one address window, decoding its run length encoded rows;
+//any char but '0'-'9', '.' and '-' is a blank cell and a cell off screen is not drawn
+void LCDWIKI_GUI::Draw_Digit(int16_t x, int16_t y, uint8_t c, uint16_t color,uint16_t bg)
+{
+	uint8_t glyph;
+	uint16_t span[DIGIT_WIDTH];
+	bool first = true;
+	if((x < 0) || (y < 0) || ((x + DIGIT_WIDTH) > Get_Width()) || ((y + DIGIT_HEIGHT) > Get_Height()))
+	{
+		return;
+	}
+	if((c >= '0') && (c <= '9'))
+	{
+		glyph = c - '0';
+	}
+	else if(c == '.')
+	{
+		glyph = 10;
+	}
+	else if(c == '-')
+	{
+		glyph = 11;
+	}
+	else
+	{
+		glyph = 12;
+	}
+	const uint8_t *rle = lcd_digits + pgm_read_word(lcd_digits_index + glyph);
+	Set_Addr_Window(x, y, x + DIGIT_WIDTH - 1, y + DIGIT_HEIGHT - 1);
+	for (uint8_t row = 0; row < DIGIT_HEIGHT; )
+	{
+		uint8_t repeat = pgm_read_byte(rle++);
+		bool fg = false;
+		for (uint8_t i = 0; i < DIGIT_WIDTH; fg = !fg)
+		{
+			uint8_t run = pgm_read_byte(rle++);
+			while(run--)
+			{
+				span[i++] = fg ? color : bg;
+			}
+		}
+		row += repeat;
+		while(repeat--)
+		{
+			Push_Any_Color(span, DIGIT_WIDTH, first, 0);
+			first = false;
+		}
+	}
+}
+
+//print a string in the large digits with the text colours
+void LCDWIKI_GUI::Print_Digits(const char *st, int16_t x, int16_t y)
+{
+	while(*st)
+	{
+		Draw_Digit(x, y, *st++, text_color, text_bgcolor);
+		x += DIGIT_WIDTH;
+	}
+}
+
 //print string
 void LCDWIKI_GUI::Print_String(const uint8_t *st, int16_t x, int16_t y)
 {
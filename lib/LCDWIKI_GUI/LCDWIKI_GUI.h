@@ -25,6 +25,14 @@
 #define RIGHT 9999
 #define CENTER 9998
 
+//the largest text size Draw_Char draws in one address window; a row of the
+//glyph takes 6*size words on the stack, larger sizes use Fill_Rect per pixel
+#define DRAW_CHAR_SPAN_SIZE 8
+
+//the cell of the large digits of Draw_Digit and Print_Digits, see LCDWIKI_digits.c
+#define DIGIT_WIDTH 36
+#define DIGIT_HEIGHT 48
+
 class LCDWIKI_GUI
 {
 	public:
@@ -82,10 +90,13 @@ class LCDWIKI_GUI
 	void Print_Number_Int(long num, int16_t x, int16_t y, int16_t length, uint8_t filler, int16_t system);
 	void Print_Number_Float(double num, uint8_t dec, int16_t x, int16_t y, uint8_t divider, int16_t length, uint8_t filler);
     void Draw_Char(int16_t x, int16_t y, uint8_t c, uint16_t color,uint16_t bg, uint8_t size, boolean mode);
+	void Draw_Digit(int16_t x, int16_t y, uint8_t c, uint16_t color,uint16_t bg);
+	void Print_Digits(const char *st, int16_t x, int16_t y);
 	size_t write(uint8_t c);
 	int16_t Get_Display_Width(void) const;
 	int16_t Get_Display_Height(void) const; 
 	protected:
+	void Draw_Char_Span(int16_t x, int16_t y, uint8_t c, uint16_t color,uint16_t bg, uint8_t size);
 	int16_t text_x, text_y;
 	uint16_t text_color, text_bgcolor,draw_color;
 	uint8_t text_size;
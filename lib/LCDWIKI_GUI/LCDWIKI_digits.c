@@ -0,0 +1,226 @@
+#ifndef DIGITS36X48_H
+#define DIGITS36X48_H
+
+#ifdef __AVR__
+ #include <avr/pgmspace.h>
+#elif defined(ESP8266)
+ #include <pgmspace.h>
+#else
+#define PROGMEM
+#endif
+
+/*
+  Large seven segment digits for instrument readouts: '0'-'9', '.', '-' and ' '
+  in a DIGIT_WIDTH x DIGIT_HEIGHT (36x48) cell, the cell of the 5x7 font at size 6.
+  A glyph is a list of row records: the number of times the row repeats, followed
+  by its run lengths, alternating background and foreground and starting with
+  background, until they add up to 36 pixels. The repeats add up to 48 rows.
+*/
+static const unsigned short lcd_digits_index[] PROGMEM = 
+{
+	0, 98, 144, 232, 320, 386, 474, 572, 634, 742, 840, 848, 872
+};
+
+static const unsigned char lcd_digits[] PROGMEM = 
+{
+	//0
+	1, 36,
+	1, 9, 18, 9,
+	1, 8, 20, 8,
+	2, 7, 22, 7,
+	1, 5, 2, 1, 20, 1, 2, 5,
+	1, 4, 4, 1, 18, 1, 4, 4,
+	14, 3, 6, 18, 6, 3,
+	1, 4, 4, 20, 4, 4,
+	1, 5, 2, 22, 2, 5,
+	2, 36,
+	1, 5, 2, 22, 2, 5,
+	1, 4, 4, 20, 4, 4,
+	14, 3, 6, 18, 6, 3,
+	1, 4, 4, 1, 18, 1, 4, 4,
+	1, 5, 2, 1, 20, 1, 2, 5,
+	2, 7, 22, 7,
+	1, 8, 20, 8,
+	1, 9, 18, 9,
+	1, 36,
+	//1
+	5, 36,
+	1, 29, 2, 5,
+	1, 28, 4, 4,
+	14, 27, 6, 3,
+	1, 28, 4, 4,
+	1, 29, 2, 5,
+	2, 36,
+	1, 29, 2, 5,
+	1, 28, 4, 4,
+	14, 27, 6, 3,
+	1, 28, 4, 4,
+	1, 29, 2, 5,
+	5, 36,
+	//2
+	1, 36,
+	1, 9, 18, 9,
+	1, 8, 20, 8,
+	2, 7, 22, 7,
+	1, 8, 20, 1, 2, 5,
+	1, 9, 18, 1, 4, 4,
+	14, 27, 6, 3,
+	1, 9, 18, 1, 4, 4,
+	1, 8, 20, 1, 2, 5,
+	2, 7, 22, 7,
+	1, 5, 2, 1, 20, 8,
+	1, 4, 4, 1, 18, 9,
+	14, 3, 6, 27,
+	1, 4, 4, 1, 18, 9,
+	1, 5, 2, 1, 20, 8,
+	2, 7, 22, 7,
+	1, 8, 20, 8,
+	1, 9, 18, 9,
+	1, 36,
+	//3
+	1, 36,
+	1, 9, 18, 9,
+	1, 8, 20, 8,
+	2, 7, 22, 7,
+	1, 8, 20, 1, 2, 5,
+	1, 9, 18, 1, 4, 4,
+	14, 27, 6, 3,
+	1, 9, 18, 1, 4, 4,
+	1, 8, 20, 1, 2, 5,
+	2, 7, 22, 7,
+	1, 8, 20, 1, 2, 5,
+	1, 9, 18, 1, 4, 4,
+	14, 27, 6, 3,
+	1, 9, 18, 1, 4, 4,
+	1, 8, 20, 1, 2, 5,
+	2, 7, 22, 7,
+	1, 8, 20, 8,
+	1, 9, 18, 9,
+	1, 36,
+	//4
+	5, 36,
+	1, 5, 2, 22, 2, 5,
+	1, 4, 4, 20, 4, 4,
+	14, 3, 6, 18, 6, 3,
+	1, 4, 4, 1, 18, 1, 4, 4,
+	1, 5, 2, 1, 20, 1, 2, 5,
+	2, 7, 22, 7,
+	1, 8, 20, 1, 2, 5,
+	1, 9, 18, 1, 4, 4,
+	14, 27, 6, 3,
+	1, 28, 4, 4,
+	1, 29, 2, 5,
+	5, 36,
+	//5
+	1, 36,
+	1, 9, 18, 9,
+	1, 8, 20, 8,
+	2, 7, 22, 7,
+	1, 5, 2, 1, 20, 8,
+	1, 4, 4, 1, 18, 9,
+	14, 3, 6, 27,
+	1, 4, 4, 1, 18, 9,
+	1, 5, 2, 1, 20, 8,
+	2, 7, 22, 7,
+	1, 8, 20, 1, 2, 5,
+	1, 9, 18, 1, 4, 4,
+	14, 27, 6, 3,
+	1, 9, 18, 1, 4, 4,
+	1, 8, 20, 1, 2, 5,
+	2, 7, 22, 7,
+	1, 8, 20, 8,
+	1, 9, 18, 9,
+	1, 36,
+	//6
+	1, 36,
+	1, 9, 18, 9,
+	1, 8, 20, 8,
+	2, 7, 22, 7,
+	1, 5, 2, 1, 20, 8,
+	1, 4, 4, 1, 18, 9,
+	14, 3, 6, 27,
+	1, 4, 4, 1, 18, 9,
+	1, 5, 2, 1, 20, 8,
+	2, 7, 22, 7,
+	1, 5, 2, 1, 20, 1, 2, 5,
+	1, 4, 4, 1, 18, 1, 4, 4,
+	14, 3, 6, 18, 6, 3,
+	1, 4, 4, 1, 18, 1, 4, 4,
+	1, 5, 2, 1, 20, 1, 2, 5,
+	2, 7, 22, 7,
+	1, 8, 20, 8,
+	1, 9, 18, 9,
+	1, 36,
+	//7
+	1, 36,
+	1, 9, 18, 9,
+	1, 8, 20, 8,
+	2, 7, 22, 7,
+	1, 8, 20, 1, 2, 5,
+	1, 9, 18, 1, 4, 4,
+	14, 27, 6, 3,
+	1, 28, 4, 4,
+	1, 29, 2, 5,
+	2, 36,
+	1, 29, 2, 5,
+	1, 28, 4, 4,
+	14, 27, 6, 3,
+	1, 28, 4, 4,
+	1, 29, 2, 5,
+	5, 36,
+	//8
+	1, 36,
+	1, 9, 18, 9,
+	1, 8, 20, 8,
+	2, 7, 22, 7,
+	1, 5, 2, 1, 20, 1, 2, 5,
+	1, 4, 4, 1, 18, 1, 4, 4,
+	14, 3, 6, 18, 6, 3,
+	1, 4, 4, 1, 18, 1, 4, 4,
+	1, 5, 2, 1, 20, 1, 2, 5,
+	2, 7, 22, 7,
+	1, 5, 2, 1, 20, 1, 2, 5,
+	1, 4, 4, 1, 18, 1, 4, 4,
+	14, 3, 6, 18, 6, 3,
+	1, 4, 4, 1, 18, 1, 4, 4,
+	1, 5, 2, 1, 20, 1, 2, 5,
+	2, 7, 22, 7,
+	1, 8, 20, 8,
+	1, 9, 18, 9,
+	1, 36,
+	//9
+	1, 36,
+	1, 9, 18, 9,
+	1, 8, 20, 8,
+	2, 7, 22, 7,
+	1, 5, 2, 1, 20, 1, 2, 5,
+	1, 4, 4, 1, 18, 1, 4, 4,
+	14, 3, 6, 18, 6, 3,
+	1, 4, 4, 1, 18, 1, 4, 4,
+	1, 5, 2, 1, 20, 1, 2, 5,
+	2, 7, 22, 7,
+	1, 8, 20, 1, 2, 5,
+	1, 9, 18, 1, 4, 4,
+	14, 27, 6, 3,
+	1, 9, 18, 1, 4, 4,
+	1, 8, 20, 1, 2, 5,
+	2, 7, 22, 7,
+	1, 8, 20, 8,
+	1, 9, 18, 9,
+	1, 36,
+	//.
+	41, 36,
+	6, 15, 6, 15,
+	1, 36,
+	//-
+	21, 36,
+	1, 9, 18, 9,
+	1, 8, 20, 8,
+	2, 7, 22, 7,
+	1, 8, 20, 8,
+	1, 9, 18, 9,
+	21, 36,
+	//space
+	48, 36,
+};
+#endif
@@ -3,10 +3,35 @@
   Project:  Yazz_Multiplexer.ino, Copyright 2020, Roy Wassili
   Contact:  waps61 @gmail.com
   URL:      https://www.hackster.io/waps61
-  VERSION:  1.05
+  VERSION:  1.06
   Date:     30-04-2020
   Last
-  Update:   18-04-2021 v1.05
+  Update:   17-10-2026 v1.06
+            NMEA sentences are parsed into field views on a char buffer; no more Strings
+            Incoming sentences are indexed and checksummed per received character
+            Tags are hashed to an ID at parse time; decoders and rules are tables per ID
+            NMEA_SPECIALTY is compiled into a flag table per tag ID
+            Sentences not special nor displayed take a fast lane without field indexing
+            Unit conversions and display values use fixed point math instead of float
+            Sentences with a bad checksum are dropped; drops are counted on the MEM page
+            NMEA_SPECIALTY conversions are rewrite rules in flash run by the parser
+            The NMEA handling moved to include/NMEACore.h, shared with tools/nmealog
+            The LIFO stack is replaced by a FIFO queue with high water and overflow counters
+            Rx2 is read by the USART2 receive interrupt instead of polling Serial2
+            The talker can use USART1 or USART3 instead of SoftwareSerial
+            The talker sends at most TALKER_BUDGET characters per loop() without waiting
+            Under load the queue sheds low priority sentences first; sheds are on the MEM page
+            Tags in RATE_LIMITS are rate limited by a token bucket; the newest is held back
+            Tags in CHANGE_ONLY are only forwarded when changed or every CHANGE_KEEPALIVE ms
+            Up to 3 listeners on Rx1, Rx2 and Rx3 are merged round-robin in loop()
+            Each listener ISR only fills a LISTENERn_RING_BYTES ring; loop() decodes it in bulk
+            update_display() only draws the characters and labels that changed per quadrant
+            The queue is shared by the NMEA_OUTPUTS, each with its own cursor and tag filter
+            All loss counters are on the MEM page and send as $PAORX and $PAOTX sentences
+            Values are drawn in a large run length encoded digit font from flash
+            The parser sets the shown values; renderDisplay() draws them at DISPLAY_FPS
+            Sentences are decoded once into the fixed point VesselData; stale values are grey
+            18-04-2021 v1.05
             Fixed a bug in the ft -> m calculation in the depth calculation
             02-09-2020 v.104
             fixed a bug in DPT sentence
@@ -125,6 +150,7 @@ Credit:
 //*** a digital input is used as a software serial port because
 //*** it can invert te signal back to its orignal pulse set
 #include <SoftwareSerial.h>
+#include <util/atomic.h>
 
 
 /*
@@ -135,139 +161,133 @@ Credit:
 // *** be ommitted from the code
 //#define DEBUG 1
 //#define TEST 1
+//#define BENCHMARK 1   // prints parser timing on the Serial monitor at start up
 #define DISPLAY_ATTACHED 1
 //#define MPU_ATTACHED 1  temprarely detached due to calibration issues
 
 #define VESSEL_NAME "YAZZ"
 #define PROGRAM_NAME "NMEAtor"
-#define PROGRAM_VERSION "1.05"
+#define PROGRAM_VERSION "1.06"
 
 #define SAMPLERATE 115200
 
-#define LISTENER_RATE 4800 // Baudrate for the listner
-#define LISTENER_PORT 53   // SoftSerial port 
+//*** The listeners on the hardware UARTs, each at its own baudrate; a rate of 0
+//*** leaves the port unused. The talker can not use the USART of a listener.
+#define LISTENER1_RATE 0     // Rx1, i.e. 38400 for an AIS receiver
+#define LISTENER2_RATE 4800  // Rx2, the instrument bus
+#define LISTENER3_RATE 0     // Rx3
+
+//*** The receive ring of each listener in bytes, a power of 2 from 256 to 2048. It must
+//*** hold all characters that come in at its rate during the longest loop(), a full
+//*** screen wipe, which takes longer than the 64 bytes of HardwareSerial last at 4800 Bd
+//*** (130ms). 256 bytes last 530ms at 4800 Bd but only 66ms at 38400 Bd; the compiler
+//*** checks every ring against LISTENER_LONGEST_LOOP at the rate of its port.
+#define LISTENER1_RING_BYTES 2048  // 38400 Bd for 300ms is 1152 characters
+#define LISTENER2_RING_BYTES 256
+#define LISTENER3_RING_BYTES 256
+//*** The longest loop() in ms: the wipe of 480x260 pixels, 2 byte writes of about 1us
+//*** each on the 8 bit bus, with some margin. Not measured on board.
+#define LISTENER_LONGEST_LOOP 300
 #define TALKER_RATE 38400  // Baudrate for the talker
 #define TALKER_PORT 50     // SoftSerial port 2
 
+//*** The talker backend. SoftwareSerial blocks loop() and all interrupts for every
+//*** character it sends; a hardware UART sends from an interrupt driven TX buffer.
+//*** For a hardware UART, connect the RS-232 RX+ to TX1 (pin 18) or TX3 (pin 14)
+//*** instead of pin 50. Build with -D SERIAL_TX_BUFFER_SIZE=128 (see platformio.ini)
+//*** so a whole sentence fits in the TX buffer.
+#define TALKER_SOFTSERIAL 0
+#define TALKER_USART1 1
+#define TALKER_USART3 3
+#define TALKER_BACKEND TALKER_SOFTSERIAL
+
+//*** The RS-232 input of the plotter needs the inverted signal. SoftwareSerial
+//*** inverts in software; a hardware UART can not, so with TALKER_USART1/3 an
+//*** external inverter (i.e. a 74HC14 gate or a MAX232) must be wired in the TX line.
+#define TALKER_INVERTED 1           // the signal on the wire must be inverted
+#define TALKER_EXTERNAL_INVERTER 0  // an inverter is wired between the TX pin and the wire
+
+//*** The most characters the talker sends per loop(), so loop() never waits long for
+//*** the line. A hardware UART gets no more than fits in its TX buffer; SoftwareSerial
+//*** blocks 10 bits per character, 8 characters at 38400 Bd take about 2ms.
+#define TALKER_BUDGET 8
+
+#if TALKER_BACKEND!=TALKER_SOFTSERIAL && TALKER_INVERTED && !TALKER_EXTERNAL_INVERTER
+#error "a hardware UART talker can not invert the signal; wire an inverter and set TALKER_EXTERNAL_INVERTER"
+#endif
+#if ( TALKER_BACKEND==TALKER_USART1 && LISTENER1_RATE ) || ( TALKER_BACKEND==TALKER_USART3 && LISTENER3_RATE )
+#error "the talker and a listener can not share a USART"
+#endif
+#if !LISTENER1_RATE && !LISTENER2_RATE && !LISTENER3_RATE
+#error "at least one listener needs a LISTENERn_RATE"
+#endif
 
-//*** Some conversion factors
-#define FTM  0.3048        // feet to meters
-#define MTF  3.28084       // meters to feet
-#define NTK  1.852         // nautical mile to km
-#define KTN  0.5399569     // km to nautical mile
 
-//*** The NMEA defines in totl 82 characters including the starting 
-//*** characters $ or ! and the checksum character *, the checksum
-//*** AND last but not least the <CR><LF> chacters.
-//*** we define one more for the terminating '\0' character for char buffers
-#define NMEA_BUFFER_SIZE 82 // According NEA0183 specs the max char is 82
-#define NMEA_TERMINATOR "\r\n"
+//*** RAM in bytes for the queue of sentences waiting to be send; adjust according use.
+//*** Each slot holds one NMEAData, one slot is always kept free.
+#define NMEA_QUEUE_BYTES 700
 
-//*** The maximum number of fields in an NMEA string
-//*** The number is based on the largest sentence MDA,
-//***  the Meteorological Composite sentence
-#define MAX_NMEA_FIELDS 21
+//*** The most talker time in ms the queue may hold before it sheds sentences of a
+//*** priority class; high priority sentences are only lost when the queue is full.
+//*** Low priority sentences are decimated to every other one above half their limit.
+#define TALKER_DELAY_LOW 250
+#define TALKER_DELAY_NORMAL 1000
 
-#define STACKSIZE 5  // Size of the stack; adjust according use
+//*** The shortest time in ms between 2 sentences of a tag on the talker; a tag that
+//*** comes more often is thinned out before it is converted and queued. Tags not
+//*** listed pass unlimited. A tag may come RATE_BURST times in a row before it is limited.
+#define RATE_LIMITS(X) X(VWR,500) X(MWV,500)
+#define RATE_BURST 2
 
-#define TALKER_ID "AO"
-#define VARIATION "1.57,E" //Varition in Lemmer on 12-05-2020, change 0.11 per year
-//*** On my boat there is an ofsett of 0.2V between the battery monitor and what 
-//*** is measured by the Robertson Databox
-#define BATTERY_OFFSET 0.2 //Volts
-//*** define NMEA tags to be used
-//*** make sure you know your Talker ID used in the sentences
-//*** In my case next to GP for navigation related sentences
-//*** II is used for Integrated Instruments and
-//*** PS is used for vendor specific tags like Stowe Marine
-//*** AO is used for my Andruino generated sentences
-
-/* for lab testing with an NMEA simulator tool
-#define _DBK "$SDDBK"   // Depth below keel
-#define _DBS "$SDDBS"   // Depth below surface
-#define _DBT "$SDDBT"   // Depth below transducer
-*/
-#define _DBK "$IIDBK"   // Depth below keel
-#define _DBS "$IIDBS"   // Depth below surface
-#define _DBT "$IIDBT"   // Depth below transducer
-#define _HDG "$IIHDG"   // Heading  Deviation & Variation
-#define _HDM "$IIHDM"   // Heading Magnetic
-#define _HDT "$IIHDT"  // Heading True
-#define _MWD "$IIMWD"  // Wind Direction & Speed
-#define _MTW "$IIMTW"  // Water Temperature
-/* for lab testing with an NMEA simulator tool
-#define _MWV "$WIMWV"  // Wind Speed and Angle
-*/
-#define _MWV "$IIMWV"  // Wind Speed and Angle
-#define _ROT "$IIROT"  // Rate of Turn
-#define _RPM "$IIRPM"  // Revolutions
-#define _RSA "$IIRSA"  // Rudder sensor angle
-#define _VDR "$IIVDR"  // Set and Drift
-#define _VHW "$IIVHW"  // Water Speed and Heading
-#define _VLW "$IIVLW"  //  Distance Traveled through Water
-#define _VTG "$IIVTG"  //  Track Made Good and Ground Speed
-#define _VWR "$IIVWR"  //  Relative Wind Speed and Angle
-#define _XDR "$IIXDR"  //  Cross Track Error  Dead Reckoning
-#define _XTE "$IIXTE"  //  Cross-Track Error  Measured
-#define _XTR "$IIXTR"  //  Cross Track Error  Dead Reckoning
-#define _ZDA "$IIZDA"  //  Time & Date - UTC, day, month, year and local time zone
-//*** Some specific GPS sentences
-#define _GLL "$GPGLL"   // Geographic Position  Latitude/Longitude
-#define _GGA "$GPGGA"   // GPS Fix Data. Time, Position and fix related data for a GPS receiver
-#define _GSA "$GPGSA"   // GPS DOP and active satellites
-#define _GSV "$GPGSV"   // Satellites in view
-#define _RMA "$GPRMA"  // Recommended Minimum Navigation Information
-#define _RMB "$GPRMB"  // Recommended Minimum Navigation Information
-#define _RMC "$GPRMC"  // Recommended Minimum Navigation Information
-
-//*** Some specific Robertson / Stowe Marine tags below
-#define _TON "$PSTON"  // Distance Nautical since reset
-#define _TOE "$PSTOE"  // Engine hours
-#define _TOB "$PSTOB"  // Battery voltage
-#define _TOD "$PSTOD"  // depth transducer below waterline in feet
-//*** Arduino generated TAGS
-#define _xDR "$" TALKER_ID "" "XDR" // Arduino Transducer measurement
-#define _dPT "$" TALKER_ID "" "DPT" // Arduino Transducer measurement
-#define _hDG "$" TALKER_ID "" "HDG" // Arduino Transducer measurement
-/* SPECIAL NOTE:
-  XDR - Transducer Measurement
-        1 2   3 4            n
-        | |   | |            |
-  $--XDR,a,x.x,a,c--c, ..... *hh<CR><LF>
-  Field Number:   1:Transducer Type
-                2:Measurement Data
-                3:Units of measurement
-                4:Name of transducer
-
-  There may be any number of quadruplets like this, each describing a sensor. The last field will be a checksum as usual.
-  Example:
-  $HCXDR,A,171,D,PITCH,A,-37,D,ROLL,G,367,,MAGX,G,2420,,MAGY,G,-8984,,MAGZ*41
-*/
+//*** Tags that are only forwarded when their content changed, or when they were not
+//*** forwarded for CHANGE_KEEPALIVE ms, so downstream timeouts do not fire.
+#define CHANGE_ONLY(X) X(MTW) X(VLW) X(xDR)
+#define CHANGE_KEEPALIVE 5000
 
-/*
-   If there is some special treatment needed for some NMEA sentences then
-   add the their definitions to the NMEA_SPECIALTY definition
-   The pre-compiler concatenates string literals by using "" in between
-*/
-#define NMEA_SPECIALTY "" _DBK "" _TOB
+//*** The health of the pipeline as proprietary sentences every STATUS_INTERVAL ms, so a
+//*** logger can relate gaps in the data to the load; 0 sends none. The fields are counts.
+//***   $PAORX,checksum,overlong,unterminated,line error,overrun,ring full,ring max  lost on the input
+//***   $PAOTX,queue full,shed high,shed normal,shed low,backlog max ms,queue max  lost on the output
+//***   $PAOFL,rate limited,unchanged  not forwarded on purpose by RATE_LIMITS and CHANGE_ONLY
+#define STATUS_INTERVAL 10000
 
-//*** A structure to hold the NMEA data
-typedef struct {
-  String fields[ MAX_NMEA_FIELDS ];
-  byte nrOfFields=0;
-  String sentence="";
+//*** The quadrants of the display are drawn at most DISPLAY_FPS times per second, from the
+//*** values the parser set last; the talker never waits for the display.
+#define DISPLAY_FPS 4
 
-}NMEAData ;
+//*** A value of the vessel data that was not received for VESSEL_STALE ms is stale;
+//*** the display shows it in grey until it is received again.
+#define VESSEL_STALE 5000
 
-char nmeaBuffer[NMEA_BUFFER_SIZE+1]={0};
+#define VARIATION "1.57,E" //Varition in Lemmer on 12-05-2020, change 0.11 per year
 
-enum NMEAReceiveStatus { INVALID, VALID, RECEIVING, CHECKSUMMING, TERMINATING, NMEA_READY};
-byte nmeaStatus = INVALID;
-byte nmeaIndex=0;
-bool nmeaDataReady = false;
+//*** The NMEA definitions, the tags and the conversions of NMEA_SPECIALTY are in
+//*** NMEACore.h, which is shared with the log tool in tools/nmealog
+#include <NMEACore.h>
+//*** The rate limiter and the change cache, also run by the host tests in test/
+#include <NMEAForward.h>
+//*** The vessel data and its decoders, also run by the host tests in test/
+#include <VesselData.h>
 
+enum NMEAReceiveStatus { INVALID, RECEIVING, CHECKSUMMING, TERMINATING };
 
-SoftwareSerial nmeaSerialOut(52,TALKER_PORT,true); // signal need to be inverted for RS-232
+
+#if TALKER_BACKEND==TALKER_USART1
+HardwareSerial &nmeaSerialOut = Serial1;
+#elif TALKER_BACKEND==TALKER_USART3
+HardwareSerial &nmeaSerialOut = Serial3;
+#else
+SoftwareSerial nmeaSerialOut(52,TALKER_PORT,TALKER_INVERTED && !TALKER_EXTERNAL_INVERTER); // signal need to be inverted for RS-232
+#endif
+
+//*** nr of characters the talker takes without waiting for the line
+int talkerAvailableForWrite(){
+  #if TALKER_BACKEND==TALKER_SOFTSERIAL
+  return TALKER_BUDGET;   // SoftwareSerial has no buffer; it waits until every character is send
+  #else
+  return nmeaSerialOut.availableForWrite();
+  #endif
+}
 
 
 /* freeMem function with varibles*/
@@ -347,7 +367,7 @@ LCDWIKI_KBV my_lcd(ILI9486,A3,A2,A1,A0,A4); //model,cs,cd,wr,rd,reset
 TouchScreen ts = TouchScreen(XP, YP, XM, YM, 300);
 
 
-int16_t current_color,flag_colour;
+int16_t current_color=WHITE,flag_colour;
 boolean show_flag = true;
 int16_t screen_row = 0;
 
@@ -453,17 +473,6 @@ String mpuNMEAString = "";
  * End MPU specific definitions
  */
 
- /*
-  * Setting fro Serial interrup
-  */
-//*** flag data on the listener port is ready
-volatile bool listenerDataReady = false;
-
-//*** ISR to set listerDataReady flag
-void listenerReady(){
-  listenerDataReady = true;
-}
-
 
 /* 
   puts a string in a foreground/background color on position x,y
@@ -476,13 +485,45 @@ void show_string(char *str,int16_t x,int16_t y,uint8_t csize,uint16_t fc, uint16
     my_lcd.Set_Text_Back_colour(bc);
     my_lcd.Print_String(str,x,y);
 }
+/*
+  What draw_quadrant() last drew in each quadrant, so a new value only draws
+  the character cells that changed and the labels are only drawn when they change.
+  A size of 0 means the quadrant is blank.
+*/
+#define QUADRANT_TEXT 8
+typedef struct {
+  char value[FIXED_TEXT_SIZE];  // as formatted by fixedFormat()
+  uint8_t size;                 // the text size of the value
+  bool stale;                   // the value is drawn in grey
+  char unit[QUADRANT_TEXT];
+  char tag[QUADRANT_TEXT];
+} QuadrantCache;
+QuadrantCache quadrantCache[4];
+
+/*
+  The value, unit and tag each quadrant should show, as set by update_display() from
+  the vessel data or the MEM page. renderDisplay() draws the dirty ones once per frame,
+  so a burst of sentences for a quadrant costs one redraw.
+*/
+typedef struct {
+  long value;         // fixed point with 1 decimal
+  const char *unit;
+  const char *tag;
+  bool stale;         // show the value in grey
+  unsigned long stamp; // the time stamp of the vessel data value that was set
+  bool dirty;         // set since the last frame
+} QuadrantState;
+QuadrantState quadrantState[4];
+
 /* 
   clears the visible part of the screen above the buttons
 */
 void wipe_screen(){
    my_lcd.Set_Draw_color(BLACK);
   my_lcd.Fill_Rectangle(0,0,480,BUTTON_Y);
-
+  //*** nothing is drawn in the quadrants anymore and the values set for the old page are void
+  memset( quadrantCache, 0, sizeof(quadrantCache) );
+  memset( quadrantState, 0, sizeof(quadrantState) );
 }
 
 /*
@@ -501,12 +542,50 @@ void screen_println(char *str,uint8_t csize,uint16_t fc, uint16_t bc,boolean mod
     my_lcd.Set_Text_Back_colour(bc);
     my_lcd.Print_String(str,0,screen_row);
     screen_row += 8*csize;
+    //*** the line may cover a quadrant; draw them all again
+    memset( quadrantCache, 0, sizeof(quadrantCache) );
 }
 
 /*
-Prints the measured value and it's units + tag combi in one of the quadrants
+  Prints a label at text size 3 when it differs from the cached one; the cells of a
+  longer previous label are cleared
 */
-void update_display(double val,const char *str, const char *tag,int8_t q){
+void update_label( char *cached, const char *str, uint16_t x, uint16_t y ){
+  if( strncmp( cached, str, QUADRANT_TEXT-1 )==0 ) return;
+  uint8_t oldLen = strlen( cached ), newLen = strlen( str );
+  my_lcd.Print_String( str,x,y);
+  if( oldLen>newLen ){
+    my_lcd.Set_Draw_color(BLACK);
+    my_lcd.Fill_Rectangle( x+newLen*18, y, x+oldLen*18-1, y+8*3-1 );
+  }
+  strncpy( cached, str, QUADRANT_TEXT-1 );
+}
+
+/*
+Sets the measured value and it's units + tag combi of one of the quadrants; it is
+drawn by the next frame of renderDisplay(), in grey if it is stale. The unit and tag
+must be constant strings.
+The value is a fixed point number with 1 decimal, i.e. 12.3 is passed as 123
+*/
+void update_display(long val,const char *str, const char *tag,int8_t q,bool stale=false){
+  if( q<Q1 || q>Q4 ) return;
+  QuadrantState &state = quadrantState[ q ];
+  state.value = val;
+  state.unit = str;
+  state.tag = tag;
+  state.stale = stale;
+  state.dirty = true;
+}
+
+/*
+Prints the value and it's units + tag combi of the vessel state in one of the quadrants
+*/
+void draw_quadrant(int8_t q){
+  long val = quadrantState[ q ].value;
+  const char *str = quadrantState[ q ].unit, *tag = quadrantState[ q ].tag;
+  bool stale = quadrantState[ q ].stale;
+  uint16_t colour = ( stale ? DARKGREY : YELLOW );
+  char valStr[FIXED_TEXT_SIZE];
   uint16_t x=0,y=0,s=6;
   // which quadrants needs an update
   switch( q ){
@@ -530,22 +609,46 @@ void update_display(double val,const char *str, const char *tag,int8_t q){
     break;
   }
     // adjust the fontsize for large numbers o fit the screen
-    if( val > 999.9) s=4; 
-    else if(val>9999.9) s=3;
-    else if(val>99999.9) s=2;
-    else if(val>999999.9) s=1;
+    if( val > 9999) s=4; 
+    else if(val>99999) s=3;
+    else if(val>999999) s=2;
+    else if(val>9999999) s=1;
     else s=6;
-    // print the value
+    QuadrantCache &cache = quadrantCache[ q ];
+    fixedFormat( valStr, val, 1, 5 );
+    // size 6 uses the large digits of the library; they have the same 36x48 cell
+    bool digits = ( s==6 );
     my_lcd.Set_Text_Mode(false);
-    my_lcd.Set_Text_Size(s);
-    my_lcd.Set_Text_colour(YELLOW);
-    my_lcd.Set_Text_Back_colour(BLACK);
-    my_lcd.Print_Number_Float(val,1,x,y,'.',5,' ');
-    // print the unit and tag
+    if( s!=cache.size || stale!=cache.stale ){
+      // another size or colour: clear what was there and print the whole value
+      if( cache.size>0 ){
+        my_lcd.Set_Draw_color(BLACK);
+        my_lcd.Fill_Rectangle( x, y, x+6*cache.size*strlen(cache.value)-1, y+8*cache.size-1 );
+      }
+      my_lcd.Set_Text_Size(s);
+      my_lcd.Set_Text_colour(colour);
+      my_lcd.Set_Text_Back_colour(BLACK);
+      if( digits ) my_lcd.Print_Digits( valStr,x,y);
+      else my_lcd.Print_String( valStr,x,y);
+    } else {
+      // only the character cells that changed; a shorter value blanks the rest
+      uint8_t oldLen = strlen( cache.value ), newLen = strlen( valStr );
+      for( uint8_t i=0; i<oldLen || i<newLen; i++ ){
+        char c = ( i<newLen ? valStr[i] : ' ' );
+        if( i<oldLen && cache.value[i]==c ) continue;
+        if( digits ) my_lcd.Draw_Digit( x+i*DIGIT_WIDTH, y, c, colour, BLACK );
+        else my_lcd.Draw_Char( x+i*6*s, y, c, colour, BLACK, s, false );
+      }
+    }
+    strncpy( cache.value, valStr, sizeof(cache.value)-1 );
+    cache.size = s;
+    cache.stale = stale;
+    // print the unit and tag when they changed
     my_lcd.Set_Text_Size(3);
     my_lcd.Set_Text_colour(WHITE);
-    my_lcd.Print_String( str,x+50,y+50);
-    my_lcd.Print_String( tag,x+120,y+50);
+    my_lcd.Set_Text_Back_colour(BLACK);
+    update_label( cache.unit, str, x+50, y+50 );
+    update_label( cache.tag, tag, x+120, y+50 );
 }
 
 /*
@@ -647,70 +750,233 @@ void debugWrite(String debugMsg)
 */
 
 /*
-  Purpose:  Helper class stacking NMEA data as a part of the multiplexer application
-            - Pushin and popping NMEAData structure on the stack for buffer purposes
+  Purpose:  Helper class queueing NMEA data as a part of the multiplexer application
+            - A FIFO ring of fixed size NMEAData slots, so sentences leave in the
+              order they arrived. The slots are in static RAM; no heap is used.
+            - There is one producer (the parser, in loop()) and a consumer per output
+              in NMEA_OUTPUTS. Every output has its own cursor into the ring and skips
+              the tags its filter does not take. A slot is free again when all
+              outputs are past it, so an extra output costs a cursor, not a copy.
+            - An output works on its oldest sentence in its slot: peek() it and
+              pop() it when done; there is no copy on the way out.
+            - A full queue drops the new sentence and counts an overflow.
+            - Each tag has a priority class. The queue knows the talker's bytes per
+              second; when the queued sentences need more talker time than the class
+              may wait, or the free slots are kept for a higher class, the new sentence
+              is shed. Low priority goes first, so heading and depth get through.
  */
-class NMEAStack
+#define NMEA_QUEUE_SLOTS ( (int)( NMEA_QUEUE_BYTES/sizeof(NMEAData) ) )
+static_assert( NMEA_QUEUE_SLOTS>=2 && NMEA_QUEUE_SLOTS<=255, "NMEA_QUEUE_BYTES must hold 2 to 255 NMEAData slots" );
+
+//*** the tags in the high and low priority class; all other tags are normal priority
+#define NMEA_PRIO_HIGH "" _HDG "" _HDM "" _HDT "" _hDG "" _DBT "" _DBS "" _dPT
+#define NMEA_PRIO_LOW "" _GSV "" _GSA
+
+static_assert( NMEA_TAG_LIST_VALID(NMEA_PRIO_HIGH),
+               "NMEA_PRIO_HIGH must be a concatenation of tags listed in NMEA_TAGS" );
+static_assert( NMEA_TAG_LIST_VALID(NMEA_PRIO_LOW),
+               "NMEA_PRIO_LOW must be a concatenation of tags listed in NMEA_TAGS" );
+
+enum nmea_priorities { PRIO_HIGH, PRIO_NORMAL, PRIO_LOW, PRIO_COUNT };
+
+//*** the priority class per tag ID in flash
+#define NMEA_TAG_PRIO(name) ( nmeaTagInList( NMEA_PRIO_HIGH, _##name ) ? PRIO_HIGH : \
+                              nmeaTagInList( NMEA_PRIO_LOW, _##name ) ? PRIO_LOW : PRIO_NORMAL ),
+const byte nmeaTagPriority[TAG_COUNT] PROGMEM = { PRIO_NORMAL, NMEA_TAGS(NMEA_TAG_PRIO) };
+
+//*** the characters per second the talker can send; 10 bits per character
+#define TALKER_BYTES_PER_SECOND ( TALKER_RATE/10 )
+
+/*
+   The outputs the sentences are send to: X(name, port, room, budget, tags)
+     port    the Print object to write to
+     room    a function returning the nr of characters the port takes without
+             waiting, or -1 while the output is off; an output that is off skips
+             its sentences and does not hold up the queue
+     budget  the most characters send per loop()
+     tags    the tags it sends, like NMEA_SPECIALTY; "" sends all, also unknown tags
+   The display shows the sentences of the first output, as it sends them.
+*/
+int usbAvailableForWrite();
+#define NMEA_OUTPUTS(X) \
+  X(TALKER, nmeaSerialOut, talkerAvailableForWrite, TALKER_BUDGET, "") \
+  X(USB, Serial, usbAvailableForWrite, 16, "")
+
+#define NMEA_OUTPUT_ENUM(name,port,room,budget,tags) OUTPUT_##name,
+enum nmea_outputs { NMEA_OUTPUTS(NMEA_OUTPUT_ENUM) OUTPUT_COUNT };
+static_assert( OUTPUT_COUNT<=8, "an output is a bit in nmeaTagOutputs" );
+
+#define NMEA_OUTPUT_TAGS_KNOWN(name,port,room,budget,tags) && NMEA_TAG_LIST_VALID(tags)
+static_assert( true NMEA_OUTPUTS(NMEA_OUTPUT_TAGS_KNOWN), "the tags of an output must be a concatenation of tags listed in NMEA_TAGS" );
+
+//*** the outputs that take a tag as a bit mask; NULL is an unknown tag
+#define NMEA_OUTPUT_TAKES(name,port,room,budget,tags) \
+  | ( tags[0]=='\0' || ( tag!=NULL && nmeaTagInList( tags, tag ) ) ? 1<<OUTPUT_##name : 0 )
+constexpr byte outputsOf(const char *tag){
+  return 0 NMEA_OUTPUTS(NMEA_OUTPUT_TAKES);
+}
+
+//*** the outputs per tag ID in flash
+#define NMEA_TAG_OUTPUTS(name) outputsOf(_##name),
+const byte nmeaTagOutputs[TAG_COUNT] PROGMEM = { outputsOf(NULL), NMEA_TAGS(NMEA_TAG_OUTPUTS) };
+
+typedef struct {
+  Print *port;
+  int (*room)();
+  byte budget;
+} NMEAOutput;
+
+#define NMEA_OUTPUT_ENTRY(name,port,room,budget,tags) { &port, room, budget },
+NMEAOutput nmeaOutputs[OUTPUT_COUNT] = { NMEA_OUTPUTS(NMEA_OUTPUT_ENTRY) };
+
+class NMEAQueue
  {
   public:
-  NMEAStack();  // Constructor with the size of the stack
-  int push( NMEAData _nmea );   // put an NMEAData struct on the stack and returns the lastIndex or -1
-  NMEAData pop();               // get an NMEAData struct from the stack and decreases the lastIndex
-  int getIndex();               // returns the position of the next free postion in the stack
+  bool push( const NMEAData &_nmea ); // copy a sentence into the queue; false if it is full or shed
+  NMEAData *peek( byte output ); // the oldest sentence for the output or NULL if there is none
+  void pop( byte output );    // the output is done with its oldest sentence
+  void skip( byte output );   // the output is off; pass all its sentences
+  byte getCount();            // nr of sentences in the queue
+  byte getHighWater();        // the most sentences ever waiting in the queue
+  unsigned long getOverflows(); // nr of sentences dropped because the queue was full
+  unsigned long getShed( byte prio ); // nr of sentences of a priority class not queued
+  unsigned int getBacklog();  // the most talker time in ms ever waiting in the queue
 
   private:
-  NMEAData stack[STACKSIZE]; // the array containg the structs
-  int lastIndex=0;    // an index pointng to the first free psotiion in the stack
+  bool admit( const NMEAData &_nmea, byte prio );
+  unsigned int getBytes();
+  NMEAData slots[NMEA_QUEUE_SLOTS];
+  volatile byte head=0;       // the next slot to fill; written by the producer only
+  volatile byte tail=0;       // the oldest slot still in use by an output
+  byte tails[OUTPUT_COUNT]={0}; // the next slot per output
+  void release();
+  volatile byte highWater=0;
+  unsigned int backlog=0;     // the most characters ever waiting in the queue
+  unsigned long overflows=0;
+  unsigned long shed[PRIO_COUNT]={0}; // shed or overflowed per priority class
+  byte decimator=0;           // alternates the decimated low priority sentences
  };
- 
-  NMEAStack::NMEAStack()
+
+  bool NMEAQueue::push( const NMEAData &_nmea )
   {
-    this->lastIndex = 0;
-    for(int i=0; i< STACKSIZE; i++ )
+    byte prio = pgm_read_byte( &nmeaTagPriority[ _nmea.tagId ] );
+    byte next = ( head+1<NMEA_QUEUE_SLOTS ? head+1 : 0 );
+    if( next==tail )
     {
-      for(int j=0; j<MAX_NMEA_FIELDS; j++ ){
-        stack[i].fields[j]="";
-      }
-      stack[i].nrOfFields = 0;
-      stack[i].sentence = "";
+      overflows++;
+      shed[prio]++;
+      return false;
     }
-  }
-  
-  int NMEAStack::push( NMEAData _nmea )
-  {
+    if( !admit( _nmea, prio ) )
+    {
+      shed[prio]++;
+      return false;
+    }
+    _nmea.copyTo( slots[ head ] );
+    __asm__ __volatile__ ( "" ::: "memory" ); // the slot is filled before it is handed over
+    head = next;
+    byte count = getCount();
+    if( count>highWater ) highWater = count;
+    unsigned int bytes = getBytes();
+    if( bytes>backlog ) backlog = bytes;
     #ifdef DEBUG
-    debugWrite( "Pushing on index:"+ String(this->lastIndex ));
+    debugWrite( "Queued: "+ String(count));
     #endif
-    if( this->lastIndex < STACKSIZE )
+    return true;
+  }
+
+  NMEAData *NMEAQueue::peek( byte output )
+  {
+    //*** pass the tags the output does not take
+    byte i = tails[ output ];
+    while( i!=head && !( pgm_read_byte( &nmeaTagOutputs[ slots[ i ].tagId ] ) & ( 1<<output ) ) )
+      i = ( i+1<NMEA_QUEUE_SLOTS ? i+1 : 0 );
+    if( i!=tails[ output ] )
     {
-      stack[ this->lastIndex++ ] = _nmea;
-      return this->lastIndex;
-    } else
+      tails[ output ] = i;
+      release();
+    }
+    return ( i!=head ? &slots[ i ] : NULL );
+  }
+
+  void NMEAQueue::pop( byte output )
+  {
+    if( tails[ output ]!=head )
     {
-      this->lastIndex = STACKSIZE;
-      return -1;    // of stack is full
+      tails[ output ] = ( tails[ output ]+1<NMEA_QUEUE_SLOTS ? tails[ output ]+1 : 0 );
+      release();
     }
   }
 
-  NMEAData NMEAStack::pop()
+  void NMEAQueue::skip( byte output )
+  {
+    tails[ output ] = head;
+    release();
+  }
+
+  //*** free the oldest slots no output needs anymore
+  void NMEAQueue::release()
   {
-    NMEAData nmeaOut;
-    nmeaOut.sentence = "";
-    if( this->lastIndex>0)
+    while( tail!=head )
     {
-      this->lastIndex--;
-      nmeaOut=stack[ this->lastIndex ];
+      for( byte o=0; o<OUTPUT_COUNT; o++ ) if( tails[ o ]==tail ) return;
+      __asm__ __volatile__ ( "" ::: "memory" ); // done with the slot before it is handed back
+      tail = ( tail+1<NMEA_QUEUE_SLOTS ? tail+1 : 0 );
     }
-    #ifdef DEBUG
-    debugWrite("Popped from index: "+String(lastIndex ));
-    #endif
-    
-    return nmeaOut;   
   }
 
-  int NMEAStack::getIndex()
+  byte NMEAQueue::getCount()
+  {
+    byte h = head;
+    byte t = tail;
+    return ( h>=t ? h-t : h+NMEA_QUEUE_SLOTS-t );
+  }
+
+  byte NMEAQueue::getHighWater()
+  {
+    return highWater;
+  }
+
+  unsigned long NMEAQueue::getOverflows()
+  {
+    return overflows;
+  }
+
+  unsigned long NMEAQueue::getShed( byte prio )
+  {
+    return shed[ prio ];
+  }
+
+  unsigned int NMEAQueue::getBacklog()
+  {
+    return (unsigned long)backlog*1000UL/TALKER_BYTES_PER_SECOND;
+  }
+
+  //*** true if the talker has time for the sentence in its priority class;
+  //*** called by the producer before the sentence gets a slot
+  bool NMEAQueue::admit( const NMEAData &_nmea, byte prio )
+  {
+    if( prio==PRIO_HIGH ) return true;
+
+    byte freeSlots = NMEA_QUEUE_SLOTS-1-getCount();
+    //*** the ms the talker needs for the queue including this sentence
+    unsigned long delay = ( getBytes()+_nmea.length )*1000UL/TALKER_BYTES_PER_SECOND;
+
+    //*** normal priority keeps the last slot free for high priority
+    if( prio==PRIO_NORMAL ) return ( freeSlots>1 && delay<=TALKER_DELAY_NORMAL );
+
+    //*** low priority keeps the last 2 slots free and is decimated before it is shed
+    if( freeSlots<=2 || delay>TALKER_DELAY_LOW ) return false;
+    if( delay>TALKER_DELAY_LOW/2 ) return ( ( ++decimator & 1 )==0 );
+    return true;
+  }
+
+  //*** the characters waiting in the queue; the slot being send counts in full
+  unsigned int NMEAQueue::getBytes()
   {
-    return this->lastIndex;
+    unsigned int bytes=0;
+    for( byte i=tail; i!=head; i=( i+1<NMEA_QUEUE_SLOTS ? i+1 : 0 ) ) bytes+=slots[ i ].length;
+    return bytes;
   }
 
  /*
@@ -734,29 +1000,34 @@ class NMEAStack
 class NMEAParser 
 {
  public:
-    NMEAParser(NMEAStack *_ptrNMEAStack);
+    NMEAParser(NMEAQueue *_ptrNMEAQueue, NMEARateLimiter *_ptrRateLimiter, NMEAChangeCache *_ptrChangeCache);
     
-    void parseNMEASentence(String nmeaIn ); // parse an NMEA sentence with each part stored in the array
+    void parseNMEASentence(const char *nmeaIn ); // parse an NMEA sentence with each part stored in the array
+    void processNMEASentence(NMEAData &nmea ); // convert, checksum and queue an already indexed sentence
+    void releaseLimited(); // queue the rate limited sentences of which the token is due
     
     unsigned long getCounter(); //return nr of sentences parsed since switched on
+    void drop( byte reason ); // count a sentence that is dropped for one of the nmea_drops reasons
+    unsigned long getDropped( byte reason ); //return nr of sentences dropped for the reason since switched on
 
   private:
-    NMEAStack *ptrNMEAStack;
-    String NMEAFilter = NMEA_SPECIALTY;
+    NMEAQueue *ptrNMEAQueue;
+    NMEARateLimiter *ptrRateLimiter;
+    NMEAChangeCache *ptrChangeCache;
     NMEAData nmeaData;  // self explaining
-    String nmeaSentence = "";
     void reset(); // clears the nmeaData struct;
-    String checksum( String str ); //calculate the checksum for str
-    NMEAData nmeaSpecialty( NMEAData nmeaIn ); // special treatment function
+    void forward( NMEAData &nmea ); // queue a sentence unless it is an unchanged repeat
+    //*** all counters are updated in loop(); the listener ISRs only fill their ring
     unsigned long counter=0;
+    unsigned long dropped[DROP_COUNT]={0};
 };
 
 // ***
 // *** NMEAParser Constructor
 // *** input parameters:
 // *** reference to the debugger object
-NMEAParser::NMEAParser(NMEAStack *_ptrNMEAStack)
-  : ptrNMEAStack(_ptrNMEAStack)
+NMEAParser::NMEAParser(NMEAQueue *_ptrNMEAQueue, NMEARateLimiter *_ptrRateLimiter, NMEAChangeCache *_ptrChangeCache)
+  : ptrNMEAQueue(_ptrNMEAQueue), ptrRateLimiter(_ptrRateLimiter), ptrChangeCache(_ptrChangeCache)
 {
   //*** initialize the NMEAData struct.
 reset();
@@ -767,193 +1038,87 @@ reset();
  * Clear the nmeaData attribute
  */
 void NMEAParser::reset(){
-  nmeaData.nrOfFields = 0;
-  nmeaData.sentence = "";
-  for(int i=0; i< MAX_NMEA_FIELDS; i++){
-    nmeaData.fields[i]="";
-  }
-  current_color=WHITE;
+  nmeaData.clear();
 }
 
 /*
-
+   parse an NMEA sentence into into an NMEAData structure.
+   The sentence is copied once into the nmeaData struct and the fields are
+   recorded as views into it; no String objects are created.
+   This is for sentences made in loop(), i.e. by the MPU; the received ones are
+   decoded from the listener rings by mergeListeners() and handed to processNMEASentence().
 */
-NMEAData NMEAParser::nmeaSpecialty( NMEAData nmeaIn )
+void NMEAParser::parseNMEASentence(const char *nmeaStr)
 {
-  String filter = NMEA_SPECIALTY;
+  reset();
   
-  NMEAData nmeaOut ;//= nmeaIn;
+  //*** check for a valid NMEA sentence
   #ifdef DEBUG
-  debugWrite( " Specialty found... for filter"+filter);
-  #endif
-  if ( filter.indexOf( nmeaIn.fields[0]) > -1 )
+    debugWrite(" In te loop to parse for "+String(strlen(nmeaStr))+" chars");
+    #endif
+  if ( nmeaStr[0] == '$' || nmeaStr[0] == '!' || nmeaStr[0] == '~' )
   {
-    /* In my on-board Robertson data network some sentences
-       are not NMEA0183 compliant. So these sentences need
-       to be converted to compliant sentences
-    */
-    //*** $IIDBK is not NMEA0183 compliant and needs conversion
-    //*** Since DBK/DBS sentences are obsolete DPT is used 
-    if ( nmeaIn.fields[0] == _DBK ) {
-      #ifdef DEBUG
-      debugWrite("Found "+String(_DBK));
-      #endif
-      // a typical non standard DBK message I receive is
-      // $IIDBK,A,0017.6,f,,,,
-      // Char A can also be a V if invalid and shoul be removed
-      // All fields after the tag shift 1 position to the left
-      // Since we modify the sentence we'll also put our talker ID in place
-      
-
-      //*** below coe is for DBT
-      //nmeaOut.fields[0]="$AODPT";
-      // for( int i=1; i<nmeaIn.nrOfFields-2; i++ )
-      // {
-      //   nmeaOut.fields[i] = nmeaIn.fields[i+1];
-      // }
-      // // We need the the feet  to convert to meters and add to string
-      // float ft = nmeaOut.fields[1].toFloat();
-      // nmeaOut.fields[3] = String( ft * FTM, 1);
-      // nmeaOut.fields[4] = "M";
-      // nmeaOut.fields[5] = "";
-      // nmeaOut.fields[6] = "";
-      // nmeaOut.nrOfFields = 7;
-
-      //*** below code is for DPT since TZ iBoat does not use DBT
-      nmeaOut.fields[0]="$AODPT";
-      if(nmeaIn.fields[3]=="f"){
-        //depth in feet need to be converted
-        float ft = nmeaIn.fields[2].toFloat();
-        nmeaOut.fields[1]=String( ft * FTM, 1);
-      } else nmeaOut.fields[1]=nmeaIn.fields[2];
-      nmeaOut.fields[2]="0.0";
-      nmeaOut.nrOfFields=3;
-      for( int i=0; i< nmeaOut.nrOfFields ; i++)
-      {
-        #ifdef DEBUG
-        debugWrite("Field["+String(i)+"] = "+nmeaOut.fields[i]);
-        #endif
-        if(i>0) nmeaOut.sentence+=",";
-        nmeaOut.sentence += nmeaOut.fields[i];
-      }
-      nmeaOut.sentence += checksum( nmeaOut.sentence );
-      
-      #ifdef DEBUG
-      debugWrite( " Modified to:"+nmeaOut.sentence);
-      #endif
-      return nmeaOut;
-    }
-
-    //*** current Battery info is in a non NMEA0183 format 
-    //*** i.e. $PSTOB,13.2,V
-    //*** will be converted to $AOXDR,U,13.2,V,BATT,*CS
-    if( nmeaIn.fields[0] == _TOB )
+    for( const char *c=nmeaStr; *c!='\0'; c++ )
     {
-      reset();
-      float batt = (nmeaIn.fields[1]).toFloat()+BATTERY_OFFSET;
-      nmeaOut.nrOfFields = 5;
-      nmeaOut.fields[0] = "$AOXDR";
-      nmeaOut.fields[1] ="U";  // the transducer unit
-      nmeaOut.fields[2] = String(batt,1);  // the actual measurement value
-      nmeaOut.fields[3] = nmeaIn.fields[2]; // unit of measure
-      nmeaOut.fields[3].toUpperCase();
-      nmeaOut.fields[4] ="BATT";
-      for( int i=0; i< nmeaOut.nrOfFields ; i++)
+      if( !nmeaData.addChar( *c ) ) // too long to be NMEA
       {
-        #ifdef DEBUG
-        debugWrite("Field["+String(i)+"] = "+nmeaOut.fields[i]);
-        #endif
-        if(i>0) nmeaOut.sentence+=",";
-        nmeaOut.sentence += nmeaOut.fields[i];
+        drop( DROP_OVERLONG );
+        return;
       }
-      nmeaOut.sentence += checksum( nmeaOut.sentence );
-      return nmeaOut;
     }
+    processNMEASentence( nmeaData );
   }
-  return nmeaOut;
-}
 
-
-
-// calculate checksum function (thanks to https://mechinations.wordpress.com)
-String NMEAParser::checksum( String str )
-{
-  byte cs = 0;
-  for (unsigned int n = 1; n < str.length(); n++)
-  {
-    if ( str[n] != '$' || str[n] != '!' || str[n] != '*' )
-    {
-      cs ^= str[n];
-    }
-  }
-
-  if (cs < 0x10) return "*0" + String(cs, HEX);
-  else return "*"+String(cs, HEX);
+  return;
 }
 
+void updateVesselState( const NMEAData &nmea );
+
 /*
-   parse an NMEA sentence into into an NMEAData structure.
+   Handle a sentence of which the field views are complete: drop it if the received
+   checksum is wrong, else convert and terminate it (see nmeaFinish() in NMEACore.h),
+   update the vessel state with it and queue it for the talker unless it is an
+   unchanged repeat. A sentence over the rate limit of its tag is held back by the
+   rate limiter until releaseLimited() finds its token due.
 */
-void NMEAParser::parseNMEASentence(String nmeaStr)
+void NMEAParser::processNMEASentence(NMEAData &nmea)
 {
-  reset();
-  int currentIndex = 0;
-  int lastIndex = -1;
-  int sentenceLength = nmeaStr.length();
-  
-  //*** check for a valid NMEA sentence
-  #ifdef DEBUG
-    debugWrite(" In te loop to parse for "+String(sentenceLength)+" chars");
-    #endif
-  if ( nmeaStr[0] == '$' || nmeaStr[0] == '!' || nmeaStr[0] == '~' )
+  if( !nmeaIdentify( nmea ) )
   {
-    
-    //*** parse the fields from the NMEA string
-    //*** keeping in mind that indeOf() can return -1 if not found!
-    currentIndex = nmeaStr.indexOf( ',',0);
-    while ( lastIndex < sentenceLength  )
-    {
-      
-      //*** remember to sepatrate fields with the ',' character
-      //*** but do not end with one!
-      if ( lastIndex>0 ) nmeaData.sentence += ',';
-
-      //*** we want the data without the ',' in fields array
-      if( currentIndex-lastIndex >1 ) // check for an empty field
-      {
-        nmeaData.fields[ nmeaData.nrOfFields ] = nmeaStr.substring(lastIndex+1, currentIndex );
-        nmeaData.sentence += nmeaData.fields[ nmeaData.nrOfFields];
-      } else nmeaData.fields[ nmeaData.nrOfFields ] = "0";
-      nmeaData.nrOfFields++;
-      lastIndex = currentIndex; // searching from next char of ',' !
-      currentIndex = nmeaStr.indexOf( ',', lastIndex+1);
-      //*** check if we found the last seperator
-      if( currentIndex < 0 )
-      {
-        //*** and make sure we parse the last part of the string too!
-        currentIndex = sentenceLength;
-      }
-      
-    }
-    if ( NMEAFilter.indexOf( nmeaData.fields[0] ) > -1)
-    {
-      nmeaData = nmeaSpecialty( nmeaData );
-    } else if(nmeaData.sentence.indexOf('*')<1)  //Check for checksum in sentence
-    {
-      nmeaData.sentence += checksum( nmeaData.sentence);
-    }
     #ifdef DEBUG
-    debugWrite("Parsed : "+nmeaData.sentence );
+    debugWrite("Bad checksum: "+String(nmea.sentence) );
     #endif
-    nmeaData.sentence += NMEA_TERMINATOR;
-    #ifdef DEBUG
-    debugWrite("Parsed & terminated: "+nmeaData.sentence );
-    #endif
-    ptrNMEAStack->push( nmeaData );   //push the struct to the stack for later use; i.e. buffer it
-    counter++; // for every sentence pushed the counter increments
+    drop( DROP_CHECKSUM );
+    return;
   }
+  //*** the checksum is tested once; nmeaConvert() would run nmeaIdentify() again
+  nmeaFinish( nmea );
+  //*** the state follows every converted sentence, also a limited, unchanged or shed one
+  updateVesselState( nmea );
+  //*** only the forwarding of a tag is limited, not its value on the display
+  if( !ptrRateLimiter->admit( nmea ) ) return;
+  forward( nmea );
+}
 
-  return;
+void NMEAParser::forward(NMEAData &nmea)
+{
+  //*** a change only tag is compared after the conversion, as it is send
+  if( !ptrChangeCache->changed( nmea ) ) return;
+  #ifdef DEBUG
+  debugWrite("Parsed & terminated: "+String(nmea.sentence) );
+  #endif
+  //*** queue the struct for the talker; a full queue counts the overflow itself
+  if( !ptrNMEAQueue->push( nmea ) ) return;
+  counter++; // for every sentence queued the counter increments
+  //*** a shed sentence uses no token and is not the last one sent
+  ptrRateLimiter->sent( nmea );
+  ptrChangeCache->sent( nmea );
+}
+
+void NMEAParser::releaseLimited()
+{
+  NMEAData *held;
+  while( ( held=ptrRateLimiter->release() )!=NULL ) forward( *held );
 }
 
 unsigned long NMEAParser::getCounter()
@@ -961,17 +1126,28 @@ unsigned long NMEAParser::getCounter()
   return counter;
 }
 
+void NMEAParser::drop( byte reason )
+{
+  if( reason<DROP_COUNT ) dropped[ reason ]++;
+}
+
+unsigned long NMEAParser::getDropped( byte reason )
+{
+  return ( reason<DROP_COUNT ? dropped[ reason ] : 0 );
+}
 
 /***********************************************************************************
    Global variables go here
 */
-NMEAStack       NmeaStack;
-NMEAParser      NmeaParser(&NmeaStack);
-NMEAData        NmeaData;
+NMEAQueue       NmeaQueue;
+NMEARateLimiter NmeaRateLimiter;
+NMEAChangeCache NmeaChangeCache;
+NMEAParser      NmeaParser(&NmeaQueue, &NmeaRateLimiter, &NmeaChangeCache);
+VesselData      Vessel;
 
 /*
   Initialize the NMEA Talker port and baudrate
-  on RX/TX port 2
+  on the TALKER_BACKEND
 */
 void initializeTalker(){
   nmeaSerialOut.begin(TALKER_RATE); 
@@ -981,268 +1157,544 @@ void initializeTalker(){
 }
 
 /*
- * Start reading converted NNMEA sentences from the stack
- * and write them to Serial Port 2 to send them to the 
+  Called by the parser for every sentence it converted; the decoder of the tag sets
+  the vessel data, which renderDisplay() shows
+*/
+void updateVesselState( const NMEAData &nmea ){
+  Vessel.decode( nmea );
+}
+
+unsigned int listenerHighWater();
+
+/*
+ * Start reading converted NNMEA sentences from the queue
+ * and write them to the NMEA_OUTPUTS, i.e. the talker to the
  * external NMEA device.
- * Update the display with the value(s) send
  */
 byte startTalking(){
-  NMEAData nmeaOut;
-  
+  static byte cursor[OUTPUT_COUNT]={0}; // the next character to send per output
   
-  #ifdef DISPLAY_ATTACHED
-  double tmpVal=0.0;
-  #endif
-  
-  //*** for all  NMEAData opjects on the stack
-  //*** NOTE; the stack has a buffer of NMEA_BUFFER_SIZE objects
-  //***       normaly only 1 or 2 should be on the stack
-  //***       if the stack is full your timing is out of control
-
-  if( NmeaStack.getIndex()>0 ){
-      nmeaOut = NmeaStack.pop();
-      //outStr =nmeaOut.sentence;
-      
-
-      for(int i=0; i< (int) nmeaOut.sentence.length(); i++){
-        //outChar[i]=outStr[i];
-        nmeaSerialOut.write( nmeaOut.sentence[i]);
-        
-      }
-      
+  //*** NOTE; the queue holds NMEA_QUEUE_SLOTS-1 sentences
+  //***       normaly only 1 or 2 should be in the queue; see the high water mark
+  //***       if the queue overflows your timing is out of control
+
+  //*** a sentence is send in parts of at most the budget of the output that the
+  //*** port takes without waiting; the rest follows in the next loop()
+  for( byte o=0; o<OUTPUT_COUNT; o++ ){
+    int room = nmeaOutputs[ o ].room();
+    if( room<0 ){
+      NmeaQueue.skip( o );
+      cursor[ o ]=0;
+      continue;
+    }
+    //*** the oldest sentence for the output; it stays in its slot until all outputs sent it
+    NMEAData *nmeaOut = NmeaQueue.peek( o );
+    if( nmeaOut==NULL ) continue;
+
+    byte budget = nmeaOutputs[ o ].budget;
+    if( room<budget ) budget = room;
+    while( budget>0 && cursor[ o ]<nmeaOut->length ){
+      nmeaOutputs[ o ].port->write( nmeaOut->sentence[ cursor[ o ]++ ] );
+      budget--;
+    }
+    if( cursor[ o ]>=nmeaOut->length ){
       #ifdef DEBUG
-      debugWrite(" Sending :" + outStr );
+      if( o==0 ) debugWrite(" Sending :" + String(nmeaOut->sentence) );
       #endif
+      NmeaQueue.pop( o );
+      cursor[ o ]=0;
+    }
   }
+  return 1;
+}
+
+//*** the USB port logs the sentences while the MEM page is shown
+int usbAvailableForWrite(){
   #ifdef DISPLAY_ATTACHED
-  // check which screens is active and update with data
-  switch (active_menu_button){
+  if( active_menu_button==MEM ) return Serial.availableForWrite();
+  #endif
+  return -1;
+}
   
-    case SPEED:
-      // speeds are checked for values <100; Higher is non existant
-      if(nmeaOut.fields[0]== _RMC){
-        tmpVal=nmeaOut.fields[7].toDouble();
-        if(tmpVal<100) update_display( tmpVal,screen_units[SPEED],"SOG",Q1);
-      }
-      if(nmeaOut.fields[0]== _VHW){
-        tmpVal=nmeaOut.fields[5].toDouble();
-        if(tmpVal<100) update_display( tmpVal,screen_units[SPEED],"STW",Q2);
-      }
-      if(nmeaOut.fields[0]== _VWR){
-        tmpVal=nmeaOut.fields[3].toDouble();
-        if(tmpVal<100) update_display( tmpVal,screen_units[SPEED],"AWS",Q3);
-        tmpVal=nmeaOut.fields[1].toDouble();
-        //char tmpChr[(nmeaOut.fields[2].length())];
-        //(nmeaOut.fields[2]).toCharArray(tmpChr,nmeaOut.fields[2].length(),0);
-      if(tmpVal<360 && nmeaOut.fields[2]=="R")update_display( tmpVal,screen_units[DEGR],"AWA",Q4);
-      else if(tmpVal<360 && nmeaOut.fields[2]=="L")update_display( tmpVal,screen_units[DEGL],"AWA",Q4);
-      }
-    break;
-    case CRS:
-        if(nmeaOut.fields[0]== _RMC){
-        tmpVal=nmeaOut.fields[8].toDouble();
-          if(tmpVal<360)update_display( tmpVal,screen_units[DEG],"TRU",Q1);
-        }
-        if(nmeaOut.fields[0]== _hDG){
-          tmpVal=nmeaOut.fields[1].toDouble();
-          if(tmpVal<360)update_display( tmpVal,screen_units[DEG],"MAG",Q2);
-        }
-        /*
-        if(nmeaOut.fields[0]== _xDR ){
-          if(nmeaOut.fields[4]== "PITCH"){
-            tmpVal=nmeaOut.fields[2].toDouble();
-            update_display( tmpVal,screen_units[DEGR],"PITCH",Q3);
-          }
-          //if we found PITCH we also have ROLL
-          if(nmeaOut.fields[8]== "ROLL"){
-            tmpVal=nmeaOut.fields[6].toDouble();
-            update_display( tmpVal,screen_units[DEGR],"ROLL",Q4);
-          }
-        }
-        */
-        if(nmeaOut.fields[0]== _dPT){
-          tmpVal=nmeaOut.fields[1].toDouble();
-          update_display( tmpVal,screen_units[MTRS],"DPT",Q3);
-        }
-        if(nmeaOut.fields[0]== _VLW){
-          tmpVal=nmeaOut.fields[3].toDouble();
-          update_display( tmpVal,screen_units[DIST],"TRP" ,Q4);
-        }
-        
-    break;
-    case LOG:
-        // Voltage an Temperature are checked <100; Higher is non exsitant.
-        if(nmeaOut.fields[0]== _xDR ){
-          if(nmeaOut.fields[4]== "BATT"){
-            tmpVal=nmeaOut.fields[2].toDouble();
-            if(tmpVal<100) update_display( tmpVal,screen_units[VOLT],"BAT",Q1);
-          }
-        }
-        if(nmeaOut.fields[0]== _MTW){
-            tmpVal=nmeaOut.fields[1].toDouble();
-            if(tmpVal<100) update_display( tmpVal,screen_units[TEMP],"WTR",Q2);
-          }
-          if(nmeaOut.fields[0]== _VLW){
-            tmpVal=nmeaOut.fields[1].toDouble();
-            update_display( tmpVal,screen_units[DIST],"LOG",Q3);
-          }
-          if(nmeaOut.fields[0]== _VLW){
-            tmpVal=nmeaOut.fields[3].toDouble();
-            update_display( tmpVal,screen_units[DIST],"TRP",Q4);
-          }
-    break;
-    case MEM:
-      default:
-      if ( (micros() - Stop2)>Timer2 )
-      {
-        Stop2 = micros();// + Timer2;                                    // Reset timer
 
+
+#ifdef DISPLAY_ATTACHED
+/*
+  Sets the quadrants of the MEM page with the health of the pipeline every Timer2 us
+*/
+void updateMemPage(){
+  long tmpVal=0;
+  static byte memPage=0;
+  if ( (micros() - Stop2)<=Timer2 ) return;
+  Stop2 = micros();// + Timer2;                                    // Reset timer
+
+  //*** the page rotates between the system info, the dropped and the shed sentences,
+  //*** the losses on the line and the talker and the sentences thinned out on purpose
+  memPage = ( memPage+1<5 ? memPage+1 : 0 );
+  if( memPage==1 ){
+    tmpVal=NmeaParser.getDropped( DROP_CHECKSUM )*10L;
+    update_display( tmpVal,"nr","CSUM",Q1);
+
+    tmpVal=NmeaParser.getDropped( DROP_OVERLONG )*10L;
+    update_display( tmpVal,"nr","LONG",Q2);
+
+    tmpVal=NmeaParser.getDropped( DROP_UNTERMINATED )*10L;
+    update_display( tmpVal,"nr","TERM",Q3);
+
+    tmpVal=NmeaQueue.getOverflows()*10L;
+    update_display( tmpVal,"nr","FULL",Q4);
+  } else if( memPage==2 ){
+    tmpVal=NmeaQueue.getShed( PRIO_HIGH )*10L;
+    update_display( tmpVal,"nr","HIGH",Q1);
+
+    tmpVal=NmeaQueue.getShed( PRIO_NORMAL )*10L;
+    update_display( tmpVal,"nr","NORM",Q2);
+
+    tmpVal=NmeaQueue.getShed( PRIO_LOW )*10L;
+    update_display( tmpVal,"nr","LOW",Q3);
+
+    tmpVal=NmeaParser.getDropped( DROP_LINE )*10L;
+    update_display( tmpVal,"nr","LINE",Q4);
+  } else if( memPage==3 ){
+    tmpVal=NmeaParser.getDropped( DROP_OVERRUN )*10L;
+    update_display( tmpVal,"nr","ORUN",Q1);
+
+    tmpVal=NmeaParser.getDropped( DROP_RINGFULL )*10L;
+    update_display( tmpVal,"nr","RFUL",Q2);
+
+    tmpVal=NmeaQueue.getBacklog()*10L;
+    update_display( tmpVal,"ms","BKLG",Q3);
+
+    tmpVal=listenerHighWater()*10L;
+    update_display( tmpVal,"max","RING",Q4);
+  } else if( memPage==4 ){
+    tmpVal=NmeaRateLimiter.getLimited()*10L;
+    update_display( tmpVal,"nr","LIMT",Q1);
+
+    tmpVal=NmeaChangeCache.getSuppressed()*10L;
+    update_display( tmpVal,"nr","SAME",Q2);
+
+    tmpVal=NmeaQueue.getCount()*10L;
+    update_display( tmpVal,"nr","QNOW",Q3);
+
+    //*** in tenths of an hour
+    tmpVal=millis()/360000L;
+    update_display( tmpVal,"h","UP",Q4);
+  } else {
+    tmpVal=getFreeSram()*10L;
+    update_display( tmpVal,"Byte","FREE",Q1);
     
+    tmpVal=0;
+    update_display( tmpVal,"V.",PROGRAM_VERSION,Q2);
+
+    tmpVal=NmeaQueue.getHighWater()*10L;
+    update_display( tmpVal,"max","QUEUE",Q3);
   
-        tmpVal=getFreeSram();
-        update_display( tmpVal,"Byte","FREE",Q1);
-        
-        tmpVal=0;
-        update_display( tmpVal,"V.",PROGRAM_VERSION,Q2);
+    tmpVal= NmeaParser.getCounter()*10L;
+    update_display(tmpVal,"nr","MSG",Q4);
+  }
+  /*
+  if( show_flag){
+    // One time instruction for logging when LOG button pressed
+    debugWrite( "Connect a cable to the serial port on" ); 
+    debugWrite("115200 Baud!");
+    debugWrite( String(PROGRAM_NAME)+" "+String(PROGRAM_VERSION));
+    debugWrite("Free SRAM:"+ String(getFreeSram()));
+    show_flag = false;
+  }
+  */
+}
 
-        tmpVal=NmeaStack.getIndex();
-        update_display( tmpVal," ","STACK",Q3);
-      
-        
-        tmpVal= NmeaParser.getCounter();
-        update_display(tmpVal,"nr","MSG",Q4);
-      }
-            /*
-      if( show_flag){
-        // One time instruction for logging when LOG button pressed
-        debugWrite( "Connect a cable to the serial port on" ); 
-        debugWrite("115200 Baud!");
-        debugWrite( String(PROGRAM_NAME)+" "+String(PROGRAM_VERSION));
-        debugWrite("Free SRAM:"+ String(getFreeSram()));
-        show_flag = false;
-      }
-      */
-      
-      Serial.print(nmeaOut.sentence);
-      
-    break;
+//*** the quantity of the vessel data shown in a quadrant of a page
+typedef struct {
+  byte quantity;
+  byte unit;        // in screen_units
+  const char *tag;
+} PageQuadrant;
+
+//*** the quadrants Q1..Q4 of the SPD, CRS and LOG pages
+const PageQuadrant vesselPages[MEM][4] PROGMEM = {
+  { { VESSEL_SOG, SPEED, "SOG" }, { VESSEL_STW, SPEED, "STW" },
+    { VESSEL_AWS, SPEED, "AWS" }, { VESSEL_AWA, DEGR, "AWA" } },
+  { { VESSEL_COG, DEG, "TRU" }, { VESSEL_HEADING, DEG, "MAG" },
+    { VESSEL_DEPTH, MTRS, "DPT" }, { VESSEL_TRIP, DIST, "TRP" } },
+  { { VESSEL_BATTERY, VOLT, "BAT" }, { VESSEL_WATER_TEMP, TEMP, "WTR" },
+    { VESSEL_LOG, DIST, "LOG" }, { VESSEL_TRIP, DIST, "TRP" } },
+};
+
+/*
+  Sets the quadrants of the active page of which the vessel data value was decoded
+  or turned stale since it was set; a quantity never decoded stays blank
+*/
+void updateVesselPage(){
+  for( int8_t q=Q1; q<=Q4; q++ ){
+    PageQuadrant page;
+    memcpy_P( &page, &vesselPages[ active_menu_button ][ q ], sizeof(page) );
+    if( !Vessel.isKnown( page.quantity ) ) continue;
+    QuadrantState &state = quadrantState[ q ];
+    unsigned long stamp = Vessel.getStamp( page.quantity );
+    bool stale = Vessel.isStale( page.quantity );
+    if( state.unit!=NULL && state.stamp==stamp && state.stale==stale ) continue;
+    long tmpVal = Vessel.get( page.quantity );
+    byte unit = page.unit;
+    // an angle to port is shown as its size with the unit to the left
+    if( unit==DEGR && tmpVal<0 ){
+      tmpVal = -tmpVal;
+      unit = DEGL;
+    }
+    update_display( tmpVal,screen_units[unit],page.tag,q,stale);
+    state.stamp = stamp;
   }
-  #endif
-  
-  
-  return 1;
 }
-  
 
+/*
+  The render task, called from loop(): sets the quadrants of the active page and
+  draws the ones that were set since the last frame, at most DISPLAY_FPS frames
+  per second whatever the rate of the input
+*/
+void renderDisplay(){
+  static unsigned long frameStop=0;
+  if( active_menu_button==MEM ) updateMemPage();
+  if( millis()-frameStop<1000/DISPLAY_FPS ) return;
+  frameStop = millis();
+  if( active_menu_button!=MEM ) updateVesselPage();
+  for( int8_t q=Q1; q<=Q4; q++ ){
+    if( !quadrantState[ q ].dirty ) continue;
+    quadrantState[ q ].dirty = false;
+    draw_quadrant( q );
+  }
+}
+#endif
 
 /**********************************************************************************
   Purpose:  Helper class reading NMEA data from the serial port as a part of the multiplexer application
             - Reading NMEA0183 v1.5 data without a checksum,
+            - A listener per hardware UART, each on its own receive interrupt, that
+              only puts the character in the receive ring of the listener.
+            - The ring of a port holds LISTENERn_RING_BYTES-1 characters, which covers
+              LISTENER_LONGEST_LOOP ms at the rate of the port. A line error or a lost
+              character is put in the ring as a marker byte, so the decoder sees it in
+              its place. Its high water mark is kept.
+            - loop() decodes the ring in bulk into the sentence being received, which
+              is indexed and checksummed while it comes in.
+            - mergeListeners() takes one sentence per port per round, so a chatty port
+              can not starve the others.
+  NOTE: the Serialn of a listener must not be used anywhere; its own ISR would clash.
 */
+class NMEAListener
+ {
+  public:
+  NMEAListener( volatile uint8_t *_ucsra, volatile uint8_t *_ucsrb, volatile uint8_t *_ucsrc,
+                volatile uint16_t *_ubrr, volatile uint8_t *_udr, byte *_ring, unsigned int _ringBytes );
+  void begin( unsigned long rate ); // set up the port and switch its receive interrupt on
+  void receive();             // called by the receive ISR of the port
+  NMEAData *poll();           // decode the ring up to a complete sentence; NULL if there is none
+  unsigned int getHighWater(); // the most characters ever waiting in the ring
 
-/*
-Cleasr the inputbuffer by reading until empty, since Serial.flush does not this anymore
-*/
-void clearNMEAInputBuffer(){
-  
-  while( Serial2.available()>0){
-    Serial2.read();
+  private:
+  void put( byte c );
+  bool store( byte c );
+  bool decode( byte cIn );
+  volatile uint8_t *ucsra, *ucsrb, *ucsrc, *udr;
+  volatile uint16_t *ubrr;
+  byte *ring;                 // LISTENERn_RING_BYTES of the port
+  unsigned int ringMask;      // the size of the ring - 1
+  volatile unsigned int head=0; // written by the ISR only
+  volatile unsigned int tail=0; // written by loop() only
+  volatile unsigned int highWater=0;
+  bool lost=false;            // a character did not fit the ring
+  NMEAData nmeaBuffer;        // the sentence being received
+  byte status=INVALID;
+ };
+
+//*** a ring is a power of 2 from 256 to 2048 bytes and holds the characters of LISTENER_LONGEST_LOOP ms
+#define LISTENER_RING_OK(bytes,rate) ( (bytes)>=256 && (bytes)<=2048 && ( (bytes) & ((bytes)-1) )==0 && \
+                                       (unsigned long)(rate)/10*LISTENER_LONGEST_LOOP/1000 < (bytes) )
+static_assert( !LISTENER1_RATE || LISTENER_RING_OK( LISTENER1_RING_BYTES, LISTENER1_RATE ),
+               "LISTENER1_RING_BYTES must be a power of 2 from 256 to 2048 that holds LISTENER_LONGEST_LOOP ms at LISTENER1_RATE" );
+static_assert( !LISTENER2_RATE || LISTENER_RING_OK( LISTENER2_RING_BYTES, LISTENER2_RATE ),
+               "LISTENER2_RING_BYTES must be a power of 2 from 256 to 2048 that holds LISTENER_LONGEST_LOOP ms at LISTENER2_RATE" );
+static_assert( !LISTENER3_RATE || LISTENER_RING_OK( LISTENER3_RING_BYTES, LISTENER3_RATE ),
+               "LISTENER3_RING_BYTES must be a power of 2 from 256 to 2048 that holds LISTENER_LONGEST_LOOP ms at LISTENER3_RATE" );
+
+//*** markers in the ring; NMEA is 7 bit ASCII, a garbled character may look like one
+#define RX_LINE_ERROR 0x80  // a framing or parity error
+#define RX_OVERRUN    0x81  // the UART lost a character
+#define RX_RINGFULL   0x82  // the ring lost a character
+
+  //*** the bits in the registers are the same for all USARTs, so the USART0 names are used
+  NMEAListener::NMEAListener( volatile uint8_t *_ucsra, volatile uint8_t *_ucsrb, volatile uint8_t *_ucsrc,
+                              volatile uint16_t *_ubrr, volatile uint8_t *_udr, byte *_ring, unsigned int _ringBytes )
+    : ucsra(_ucsra), ucsrb(_ucsrb), ucsrc(_ucsrc), udr(_udr), ubrr(_ubrr), ring(_ring), ringMask(_ringBytes-1)
+  {
   }
 
-}
+  void NMEAListener::begin( unsigned long rate )
+  {
+    *ucsrb = 0;
+    //*** same baud rate settings as HardwareSerial: double speed mode
+    *ucsra = _BV(U2X0);
+    *ubrr = ( F_CPU / 4 / rate - 1 ) / 2;
+    *ucsrc = _BV(UCSZ01) | _BV(UCSZ00);   // 8N1
+    //*** clear the input buffer before the interrupt is switched on
+    while( *ucsra & _BV(RXC0) ) (void)*udr;
+    *ucsrb = _BV(RXEN0) | _BV(RXCIE0);
+  }
+
+  void NMEAListener::receive()
+  {
+    byte lineStatus = *ucsra;   // must be read before udr
+    byte cIn = *udr;
+    if( lineStatus & ( _BV(FE0) | _BV(DOR0) | _BV(UPE0) ) )
+    {
+      //*** a character got lost or garbled; a sentence without checksum would pass unnoticed
+      put( lineStatus & _BV(DOR0) ? RX_OVERRUN : RX_LINE_ERROR );
+      if( cIn!='$' && cIn!='!' && cIn!='~' ) return;
+    }
+    put( cIn );
+  }
+
+  //*** put a character in the ring; after a loss the marker goes first
+  void NMEAListener::put( byte c )
+  {
+    if( lost ){
+      if( !store( RX_RINGFULL ) ) return;
+      lost = false;
+    }
+    if( !store( c ) ) lost = true;
+  }
+
+  bool NMEAListener::store( byte c )
+  {
+    unsigned int next = ( head+1 ) & ringMask;
+    if( next==tail ) return false;
+    ring[ head ] = c;
+    head = next;
+    unsigned int count = ( head-tail ) & ringMask;
+    if( count>highWater ) highWater = count;
+    return true;
+  }
+
+  /*
+    Decode the ring up to the end of a sentence or the last character received;
+    head is read and tail is written once, as 2 bytes they need the interrupts off.
+  */
+  NMEAData *NMEAListener::poll()
+  {
+    unsigned int h;
+    ATOMIC_BLOCK( ATOMIC_RESTORESTATE ){
+      h = head;
+    }
+    unsigned int t = tail;
+    bool complete = false;
+    while( t!=h && !complete ){
+      complete = decode( ring[ t ] );
+      t = ( t+1 ) & ringMask;
+    }
+    ATOMIC_BLOCK( ATOMIC_RESTORESTATE ){
+      tail = t;
+    }
+    return ( complete ? &nmeaBuffer : NULL );
+  }
+
+  unsigned int NMEAListener::getHighWater()
+  {
+    unsigned int n;
+    ATOMIC_BLOCK( ATOMIC_RESTORESTATE ){
+      n = highWater;
+    }
+    return n;
+  }
+
+  /*
+    Decode the incomming character and test if it is valid NMEA data.
+    If true than add it to the NMEA buffer, which keeps track of the fields and
+    the checksum while the sentence comes in.
+    returns true when the sentence in nmeaBuffer is complete
+  */
+  bool NMEAListener::decode( byte cIn )
+  {
+    switch( cIn ){
+      case RX_OVERRUN:
+      case RX_RINGFULL:
+        NmeaParser.drop( cIn==RX_OVERRUN ? DROP_OVERRUN : DROP_RINGFULL );
+        status = INVALID;
+        return false;
+      case RX_LINE_ERROR:
+        if( status==RECEIVING || status==CHECKSUMMING ) NmeaParser.drop( DROP_LINE );
+        status = INVALID;
+        return false;
+      case '~':
+        // reserved by NMEA
+      case '!':
+        //for AIS info
+      case '$':
+        // for general NMEA info
+        // a new start while the previous sentence is still coming in: it lost its <CR><LF>
+        if( status==RECEIVING || status==CHECKSUMMING ) NmeaParser.drop( DROP_UNTERMINATED );
+        status = RECEIVING;
+        nmeaBuffer.clear();
+        break;
+      case '*':
+        if( status==RECEIVING ) status = CHECKSUMMING;
+        break;
+      case '\n':
+      case '\r':
+        // in old v1.5 version, NMEA Data may not be checksummed!
+        status = ( status==RECEIVING || status==CHECKSUMMING ? TERMINATING : INVALID );
+        break;
+    }
+    switch( status ){
+      case RECEIVING:
+      case CHECKSUMMING:
+        // a sentence that does not fit the buffer is no NMEA; wait for the next one
+        if( !nmeaBuffer.addChar( cIn ) ){
+          NmeaParser.drop( DROP_OVERLONG );
+          status = INVALID;
+        }
+        break;
+      case TERMINATING:
+        status = INVALID;
+        return true;
+    }
+    return false;
+  }
+
+#if LISTENER1_RATE
+byte listener1Ring[LISTENER1_RING_BYTES];
+NMEAListener Listener1( &UCSR1A, &UCSR1B, &UCSR1C, &UBRR1, &UDR1, listener1Ring, LISTENER1_RING_BYTES );
+ISR(USART1_RX_vect){ Listener1.receive(); }
+#endif
+#if LISTENER2_RATE
+byte listener2Ring[LISTENER2_RING_BYTES];
+NMEAListener Listener2( &UCSR2A, &UCSR2B, &UCSR2C, &UBRR2, &UDR2, listener2Ring, LISTENER2_RING_BYTES );
+ISR(USART2_RX_vect){ Listener2.receive(); }
+#endif
+#if LISTENER3_RATE
+byte listener3Ring[LISTENER3_RING_BYTES];
+NMEAListener Listener3( &UCSR3A, &UCSR3B, &UCSR3C, &UBRR3, &UDR3, listener3Ring, LISTENER3_RING_BYTES );
+ISR(USART3_RX_vect){ Listener3.receive(); }
+#endif
+
+//*** the listeners in the order of the round-robin
+NMEAListener * const listeners[] = {
+#if LISTENER1_RATE
+  &Listener1,
+#endif
+#if LISTENER2_RATE
+  &Listener2,
+#endif
+#if LISTENER3_RATE
+  &Listener3,
+#endif
+};
+#define LISTENER_COUNT ( (byte)( sizeof(listeners)/sizeof(listeners[0]) ) )
 
 void initializeListener()
 {
-  Serial2.begin(LISTENER_RATE);
-  clearNMEAInputBuffer();
+  #if LISTENER1_RATE
+  Listener1.begin( LISTENER1_RATE );
+  #endif
+  #if LISTENER2_RATE
+  Listener2.begin( LISTENER2_RATE );
+  #endif
+  #if LISTENER3_RATE
+  Listener3.begin( LISTENER3_RATE );
+  #endif
   #ifdef DEBUG
   debugWrite( "Listener initialized...");
   #endif
 }
 
 /*
-  Decode the incomming character and test if it is valid NMEA data.
-  If true than put it the NMEA buffer and call NMEAParser object
-  to process incomming and complete MNEA sentence
+  Decode the rings of the listeners and hand the complete sentences to the parser
+  to be converted and queued: one per port per round, each loop() starting at the
+  next port, until all rings are empty.
 */
-void decodeNMEAInput(char cIn){
-  switch( cIn ){
-    case '~':
-      // reserved by NMEA
-    case '!':
-      //for AIS info
-    case '$':
-      // for general NMEA info
-      nmeaStatus = RECEIVING;
-      nmeaIndex=0;
-      break;
-    case '*':
-      if(nmeaStatus==RECEIVING){
-      nmeaStatus = CHECKSUMMING;
+void mergeListeners()
+{
+  static byte first=0;
+  bool more = true;
+  while( more )
+  {
+    more = false;
+    byte port = first;
+    for( byte n=0; n<LISTENER_COUNT; n++ )
+    {
+      NMEAData *nmea = listeners[ port ]->poll();
+      if( nmea!=NULL ){
+        #ifdef DEBUG
+        debugWrite( nmea->sentence );
+        #endif
+        NmeaParser.processNMEASentence( *nmea );
+        more = true;
       }
-      break;
-    case '\n':
-    case '\r':
-      // in old v1.5 version, NMEA Data may not be checksummed!
-      if(nmeaStatus== RECEIVING || nmeaStatus==CHECKSUMMING){
-        nmeaDataReady = true;
-        nmeaStatus = TERMINATING;
-      } else nmeaStatus = INVALID;
-      
-      break;
-    
+      port = ( port+1<LISTENER_COUNT ? port+1 : 0 );
+    }
   }
-  switch(nmeaStatus){
-    case INVALID:
-      // do nothing
-      nmeaIndex=0;
-      nmeaDataReady = false;
-      break;
-    case RECEIVING:
-    case CHECKSUMMING:
-      nmeaBuffer[nmeaIndex] = cIn;
-      nmeaIndex++;
-      break;
-    case TERMINATING:
-    
-    nmeaStatus = INVALID;
-    if( nmeaDataReady){
-      nmeaDataReady = false;
-      
-      // Clear the remaining buffer content with '\0'
-      for(int y=nmeaIndex+1; y<NMEA_BUFFER_SIZE+1; y++){
-        nmeaBuffer[y]='\0';
-      }
-      #ifdef DEBUG
-      debugWrite( nmeaBuffer);
-      #endif
-      NmeaParser.parseNMEASentence( nmeaBuffer );
+  first = ( first+1<LISTENER_COUNT ? first+1 : 0 );
+}
 
-      //clear the NMEAbuffer with 0
-      memset( nmeaBuffer, 0, NMEA_BUFFER_SIZE+1);
-      nmeaIndex=0;
-    }
-    
-      break;
+//*** the most characters ever waiting in the ring of any listener
+unsigned int listenerHighWater()
+{
+  unsigned int most = 0;
+  for( byte n=0; n<LISTENER_COUNT; n++ )
+  {
+    unsigned int count = listeners[ n ]->getHighWater();
+    if( count>most ) most = count;
   }
+  return most;
 }
 
+
+
 /*
- * Start listeneing for incomming NNMEA sentences
- */
-void startListening()
+  Send the loss counters as $PAORX and $PAOTX and the filter counters as $PAOFL every
+  STATUS_INTERVAL ms; they go through the parser and the queue like any other sentence.
+*/
+void statusField( char *&p, unsigned long n )
 {
-  #ifdef DEBUG
-    debugWrite("Listening....");
-    #endif
-  
-  while(  Serial2.available()>0 && nmeaStatus != TERMINATING){
-    decodeNMEAInput( Serial2.read());
-  }
-  
-  
+  *p++ = ',';
+  ultoa( n, p, 10 );
+  p += strlen( p );
 }
 
+void reportStatus()
+{
+  static unsigned long statusStop=0;
+  if( STATUS_INTERVAL==0 || millis()-statusStop<STATUS_INTERVAL ) return;
+  statusStop = millis();
+
+  //*** 6 fields of at most 10 digits and the ring high water fit an NMEA sentence
+  char status[NMEA_BUFFER_SIZE];
+  char *p = status;
+  p += strlen( strcpy( p, "$P" TALKER_ID "RX" ) );
+  statusField( p, NmeaParser.getDropped( DROP_CHECKSUM ) );
+  statusField( p, NmeaParser.getDropped( DROP_OVERLONG ) );
+  statusField( p, NmeaParser.getDropped( DROP_UNTERMINATED ) );
+  statusField( p, NmeaParser.getDropped( DROP_LINE ) );
+  statusField( p, NmeaParser.getDropped( DROP_OVERRUN ) );
+  statusField( p, NmeaParser.getDropped( DROP_RINGFULL ) );
+  statusField( p, listenerHighWater() );
+  NmeaParser.parseNMEASentence( status );
+
+  p = status;
+  p += strlen( strcpy( p, "$P" TALKER_ID "TX" ) );
+  statusField( p, NmeaQueue.getOverflows() );
+  statusField( p, NmeaQueue.getShed( PRIO_HIGH ) );
+  statusField( p, NmeaQueue.getShed( PRIO_NORMAL ) );
+  statusField( p, NmeaQueue.getShed( PRIO_LOW ) );
+  statusField( p, NmeaQueue.getBacklog() );
+  statusField( p, NmeaQueue.getHighWater() );
+  NmeaParser.parseNMEASentence( status );
+
+  p = status;
+  p += strlen( strcpy( p, "$P" TALKER_ID "FL" ) );
+  statusField( p, NmeaRateLimiter.getLimited() );
+  statusField( p, NmeaChangeCache.getSuppressed() );
+  NmeaParser.parseNMEASentence( status );
+}
 
 
 /*
@@ -1590,9 +2042,9 @@ void readIMUSensor(){
   if (heading > 360) heading -= 360.0;
   
   mpuNMEAString = "$"+String(TALKER_ID)+"HDG,"+String(heading,1)+",,,"+String(VARIATION);
-  NmeaParser.parseNMEASentence( mpuNMEAString );
+  NmeaParser.parseNMEASentence( mpuNMEAString.c_str() );
   mpuNMEAString = "$"+String(TALKER_ID)+"XDR,,"+String((imu.pitch * RAD_TO_DEG),1)+",D,PITCH,,"+String((imu.roll * RAD_TO_DEG),1)+",D,ROLL";
-  NmeaParser.parseNMEASentence( mpuNMEAString );
+  NmeaParser.parseNMEASentence( mpuNMEAString.c_str() );
   startTalking();
 }
 #endif
@@ -1600,9 +2052,9 @@ void readIMUSensor(){
  * End MPU related functions
  */
 
-#ifdef TEST
+#if defined(TEST) || defined(BENCHMARK)
 
-String NmeaStream[10] ={
+const char *NmeaStream[10] ={
   "$IIVWR,151,R,02.4,N,,,,",
   "$IIMTW,12.2,C",
   "!AIVDM,1,1,,A,13aL<mhP000J9:PN?<jf4?vLP88B,0*2B",
@@ -1614,6 +2066,9 @@ String NmeaStream[10] ={
   "$IIVWR,151,R,02.3,N,,,,",
   "$IIVHW,,,000,M,01.57,N,,"
   };
+#endif
+
+#ifdef TEST
 
  int softIndex = 0;
  long softTimerOld = 0;
@@ -1651,6 +2106,167 @@ void runSoftGenerator()
 
 #endif
 
+#ifdef BENCHMARK
+/*
+ * Timing of the NMEA handling building blocks. Each block runs BENCHMARK_RUNS times
+ * over the NmeaStream sentences and the average is printed on the Serial monitor
+ * in CPU cycles per sentence. micros() has a resolution of 4us, hence the many runs.
+ */
+#define BENCHMARK_RUNS 100
+
+volatile byte benchSink = 0; // keeps the compiler from optimizing the work away
+
+//*** the String based field split of the v1.05 parser, kept as a reference
+void benchLegacySplit(const char *nmeaIn)
+{
+  String nmeaStr = nmeaIn;
+  String fields[ MAX_NMEA_FIELDS ];
+  String sentence = "";
+  byte nrOfFields = 0;
+  int lastIndex = -1;
+  int sentenceLength = nmeaStr.length();
+  int currentIndex = nmeaStr.indexOf( ',',0);
+  while ( lastIndex < sentenceLength && nrOfFields < MAX_NMEA_FIELDS )
+  {
+    if ( lastIndex>0 ) sentence += ',';
+    if( currentIndex-lastIndex >1 )
+    {
+      fields[ nrOfFields ] = nmeaStr.substring(lastIndex+1, currentIndex );
+      sentence += fields[ nrOfFields ];
+    } else fields[ nrOfFields ] = "0";
+    nrOfFields++;
+    lastIndex = currentIndex;
+    currentIndex = nmeaStr.indexOf( ',', lastIndex+1);
+    if( currentIndex < 0 ) currentIndex = sentenceLength;
+  }
+  benchSink = nrOfFields;
+}
+
+//*** the zero allocation field views of NMEAData, built per character
+void benchTokenize(const char *nmeaIn)
+{
+  NMEAData nmea;
+  for( const char *c=nmeaIn; *c!='\0'; c++ ) nmea.addChar( *c );
+  benchSink = nmea.nrOfFields;
+}
+
+//*** the complete path of a sentence through the parser and the queue
+void benchPipeline(const char *nmeaIn)
+{
+  NmeaParser.parseNMEASentence( nmeaIn );
+  NMEAData *nmea = NmeaQueue.peek( OUTPUT_TALKER );
+  if( nmea!=NULL ){
+    benchSink = nmea->length;
+    for( byte o=0; o<OUTPUT_COUNT; o++ ) NmeaQueue.pop( o );
+  }
+}
+
+//*** the depth conversion of a DBK sentence; the sentence is only the pace maker
+const char * volatile benchDepth = "17.6";
+
+//*** the v1.05 conversion: atof, float math and dtostrf
+void benchFloatConvert(const char *nmeaIn)
+{
+  char value[FIXED_TEXT_SIZE];
+  float ft = atof( benchDepth );
+  benchSink = dtostrf( ft * FTM, 3, 1, value )[0];
+}
+
+//*** the same conversion in fixed point
+void benchFixedConvert(const char *nmeaIn)
+{
+  char value[FIXED_TEXT_SIZE];
+  long ft = fixedParse( benchDepth, strlen( benchDepth ), 1 );
+  benchSink = fixedFormat( value, fixedScale( ft, FTM_MUL, FTM_DIV ), 1, 3 )[0];
+}
+
+//*** returns the average nr of cycles fn takes per NmeaStream sentence
+unsigned long benchCycles( void (*fn)(const char *) )
+{
+  unsigned long start = micros();
+  for( int r=0; r<BENCHMARK_RUNS; r++ )
+  {
+    for( byte i=0; i<10; i++ ) fn( NmeaStream[i] );
+  }
+  return ( (micros()-start) * (F_CPU/1000000L) ) / ( BENCHMARK_RUNS*10L );
+}
+
+//*** prints and returns the cycles of fn
+unsigned long benchReport( const char *label, void (*fn)(const char *) )
+{
+  unsigned long cycles = benchCycles( fn );
+  Serial.print( label );
+  Serial.print( ": " );
+  Serial.print( cycles );
+  Serial.println( " cycles/sentence" );
+  return cycles;
+}
+
+/*
+ * The loop() time left over while the talker sends at full load. A loop counts how
+ * much work it gets done in the time the line needs for BENCHMARK_SENTENCES sentences
+ * of the maximum length, once idle and once while feeding the talker a character
+ * whenever it takes one. The difference is the time the talker costs loop(), with
+ * the TX interrupts of a hardware UART included.
+ */
+#define BENCHMARK_SENTENCES 20
+
+unsigned long benchTalkerWork( unsigned long window, const char *sentence )
+{
+  unsigned long count = 0;
+  byte i = 0;
+  unsigned long start = micros();
+  while( micros()-start < window )
+  {
+    if( sentence!=NULL )
+    {
+      //*** SoftwareSerial has no buffer and always blocks
+      if( talkerAvailableForWrite()>0 )
+      {
+        nmeaSerialOut.write( sentence[i++] );
+        if( sentence[i]=='\0' ) i = 0;
+      }
+    }
+    count++;
+  }
+  return count;
+}
+
+void benchTalker()
+{
+  char sentence[NMEA_BUFFER_SIZE+1];
+  memset( sentence, '0', NMEA_BUFFER_SIZE );
+  memcpy( sentence, "$AOTST,", 7 );
+  memcpy( sentence+NMEA_BUFFER_SIZE-2, NMEA_TERMINATOR, 3 );
+  //*** 10 bits per character
+  unsigned long lineTime = NMEA_BUFFER_SIZE*10*1000000L/TALKER_RATE;
+  unsigned long idle = benchTalkerWork( BENCHMARK_SENTENCES*lineTime, NULL );
+  unsigned long busy = benchTalkerWork( BENCHMARK_SENTENCES*lineTime, sentence );
+  Serial.print( "talker, line time " );
+  Serial.print( lineTime );
+  Serial.print( " us/sentence, loop time left " );
+  Serial.print( lineTime*busy/idle );
+  Serial.println( " us/sentence" );
+}
+
+void runBenchmark()
+{
+  Serial.println( "Benchmark " PROGRAM_NAME " " PROGRAM_VERSION );
+  long splitCycles = benchReport( "String field split (v1.05)", benchLegacySplit );
+  long viewCycles = benchReport( "NMEAData addChar", benchTokenize );
+  Serial.print( "field views save: " );
+  Serial.print( splitCycles-viewCycles );
+  Serial.println( " cycles/sentence" );
+  benchReport( "parse, queue and pop", benchPipeline );
+  long floatCycles = benchReport( "ft to m in float", benchFloatConvert );
+  long fixedCycles = benchReport( "ft to m in fixed point", benchFixedConvert );
+  Serial.print( "fixed point saves: " );
+  Serial.print( floatCycles-fixedCycles );
+  Serial.println( " cycles/sentence" );
+  benchTalker();
+}
+#endif
+
 
 void setup() {
   // put your setup code here, to run once:
@@ -1680,8 +2296,13 @@ void setup() {
   } 
   #endif
 
-  initializeListener();
   initializeTalker();
+
+  #ifdef BENCHMARK
+  runBenchmark();
+  #endif
+
+  initializeListener();
     
   #ifdef DISPLAY_ATTACHED
   show_menu();
@@ -1713,13 +2334,17 @@ void loop() {
     readIMUSensor(); 
   }
   #endif
-  startListening();
- 
   #ifdef DISPLAY_ATTACHED
   buttonPressed();
   #endif
  
+  mergeListeners();
+  NmeaParser.releaseLimited();
+  reportStatus();
   startTalking();
+  #ifdef DISPLAY_ATTACHED
+  renderDisplay();
+  #endif
   
 }
 
@@ -0,0 +1,47 @@
+/*
+  Project:  Yazz_Multiplexer.ino, Copyright 2020, Roy Wassili
+  File:     test/host/check.h
+  Purpose:  The few helpers the host tests share: a CHECK that reports the line and
+            goes on, and a sentence received and converted the way the multiplexer
+            does it.
+*/
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <NMEACore.h>
+
+#include <stdio.h>
+#include <string.h>
+
+static int checks = 0;
+static int failures = 0;
+
+#define CHECK(cond) do { \
+    checks++; \
+    if( !(cond) ) { printf( "%s:%d: CHECK( %s ) failed\n", __FILE__, __LINE__, #cond ); failures++; } \
+  } while( 0 )
+
+#define CHECK_STR(str, expected) do { \
+    checks++; \
+    if( strcmp( (str), (expected) )!=0 ) { \
+      printf( "%s:%d: \"%s\" is not \"%s\"\n", __FILE__, __LINE__, (str), (expected) ); failures++; \
+    } \
+  } while( 0 )
+
+//*** feed str through NMEAData::addChar() like the listener does and convert it;
+//*** returns false if the sentence does not fit or its checksum is wrong
+inline bool receive(NMEAData &nmea, const char *str)
+{
+  nmea.clear();
+  for( ; *str!='\0'; str++ ) if( !nmea.addChar( *str ) ) return false;
+  return nmeaConvert( nmea );
+}
+
+//*** the summary line and the exit code of a test program
+inline int report(const char *name)
+{
+  printf( "%s: %d checks, %d failed\n", name, checks, failures );
+  return ( failures==0 ? 0 : 1 );
+}
+
+#endif
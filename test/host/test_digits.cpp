@@ -0,0 +1,45 @@
+/*
+  Project:  Yazz_Multiplexer.ino, Copyright 2020, Roy Wassili
+  File:     test/host/test_digits.cpp
+  Purpose:  Host test of the run length encoded digits of LCDWIKI_digits.c, which
+            Draw_Digit() decodes without any bounds check: every row record must add
+            up to 36 pixels, every glyph to 48 rows, and the index must point at the
+            start of each glyph.
+*/
+
+#include "check.h"
+#include <LCDWIKI_digits.c>
+
+#define DIGIT_WIDTH 36
+#define DIGIT_HEIGHT 48
+#define DIGIT_GLYPHS ( sizeof(lcd_digits_index)/sizeof(lcd_digits_index[0]) )
+
+//*** walks a glyph the way Draw_Digit() does; returns the offset after its last record
+unsigned int checkGlyph(byte glyph, unsigned int pos)
+{
+  CHECK( lcd_digits_index[glyph]==pos );
+  byte rows = 0;
+  while( rows<DIGIT_HEIGHT && pos<sizeof(lcd_digits) )
+  {
+    byte repeat = lcd_digits[pos++];
+    CHECK( repeat>0 );
+    byte width = 0;
+    while( width<DIGIT_WIDTH && pos<sizeof(lcd_digits) ) width += lcd_digits[pos++];
+    if( width!=DIGIT_WIDTH ) printf( "glyph %d, row %d: %d pixels\n", glyph, rows, width );
+    CHECK( width==DIGIT_WIDTH );
+    rows += repeat;
+  }
+  if( rows!=DIGIT_HEIGHT ) printf( "glyph %d: %d rows\n", glyph, rows );
+  CHECK( rows==DIGIT_HEIGHT );
+  return pos;
+}
+
+int main()
+{
+  //*** '0'-'9', '.', '-' and ' '
+  CHECK( DIGIT_GLYPHS==13 );
+  unsigned int pos = 0;
+  for( byte glyph=0; glyph<DIGIT_GLYPHS; glyph++ ) pos = checkGlyph( glyph, pos );
+  CHECK( pos==sizeof(lcd_digits) );
+  return report( "test_digits" );
+}
@@ -0,0 +1,125 @@
+/*
+  Project:  Yazz_Multiplexer.ino, Copyright 2020, Roy Wassili
+  File:     test/host/test_forward.cpp
+  Purpose:  Host tests of NMEAForward.h: the hold back of the rate limiter and the
+            change cache, with the settings of src/main.cpp and a clock of our own.
+*/
+
+#define RATE_LIMITS(X) X(VWR,500) X(MWV,500)
+#define RATE_BURST 2
+#define CHANGE_ONLY(X) X(MTW) X(VLW) X(xDR)
+#define CHANGE_KEEPALIVE 5000
+
+#include "check.h"
+#include <NMEAForward.h>
+
+static unsigned long now = 1000;
+unsigned long millis()
+{
+  return now;
+}
+
+void testRateLimiter()
+{
+  NMEARateLimiter limiter;
+  NMEAData vwr, other;
+  CHECK( receive( other, "$IIVHW,,,,,5.2,N,," ) );
+  CHECK( limiter.admit( other ) );   // not limited
+
+  //*** RATE_BURST sentences in a row pass, as long as they are sent
+  CHECK( receive( vwr, "$IIVWR,045.0,R,10.5,N,,,," ) );
+  CHECK( limiter.admit( vwr ) );
+  limiter.sent( vwr );
+  now += 10;
+  CHECK( limiter.admit( vwr ) );
+  limiter.sent( vwr );
+
+  //*** the next one is held back and replaced by a newer one
+  now += 10;
+  CHECK( !limiter.admit( vwr ) );
+  CHECK( limiter.getLimited()==0 );
+  now += 10;
+  CHECK( receive( vwr, "$IIVWR,045.0,R,11.5,N,,,," ) );
+  CHECK( !limiter.admit( vwr ) );
+  CHECK( limiter.getLimited()==1 );
+  CHECK( limiter.release()==NULL );
+
+  //*** the newest is released when the token is due, one interval after the 2nd
+  now = 1500;
+  NMEAData *held = limiter.release();
+  CHECK( held!=NULL );
+  if( held!=NULL ) CHECK( strncmp( held->sentence, "$IIVWR,045.0,R,11.5,", 20 )==0 );
+  CHECK( limiter.release()==NULL );
+
+  //*** it was shed, so the token is left for the next one
+  CHECK( limiter.admit( vwr ) );
+  limiter.sent( vwr );
+  CHECK( !limiter.admit( vwr ) );
+  CHECK( limiter.getLimited()==1 );
+}
+
+void testRateLimiterBurst()
+{
+  NMEARateLimiter limiter;
+  NMEAData vwr;
+  char str[NMEA_SENTENCE_SIZE];
+  byte passed = 0;
+  now = 5000;
+
+  //*** ten VWR in 200 ms: RATE_BURST pass, the newest of the others is held
+  for( byte i=0; i<10; i++, now+=20 )
+  {
+    snprintf( str, sizeof(str), "$IIVWR,045.0,R,%d.5,N,,,,", 10+i );
+    CHECK( receive( vwr, str ) );
+    if( limiter.admit( vwr ) )
+    {
+      limiter.sent( vwr );
+      passed++;
+    }
+  }
+  CHECK( passed==RATE_BURST );
+  CHECK( limiter.getLimited()==7 );
+  now = 6000;
+  NMEAData *held = limiter.release();
+  CHECK( held!=NULL );
+  if( held!=NULL ) CHECK( strncmp( held->sentence, "$IIVWR,045.0,R,19.5,", 20 )==0 );
+}
+
+void testChangeCache()
+{
+  NMEAChangeCache cache;
+  NMEAData mtw, other;
+  now = 10000;
+  CHECK( receive( other, "$IIVHW,,,,,5.2,N,," ) );
+  CHECK( cache.changed( other ) );
+  cache.sent( other );
+  CHECK( cache.changed( other ) );  // not in CHANGE_ONLY
+
+  //*** a changed value that is not sent, i.e. shed by the queue, is not recorded
+  CHECK( receive( mtw, "$IIMTW,12.5,C" ) );
+  CHECK( cache.changed( mtw ) );
+  CHECK( cache.changed( mtw ) );
+  cache.sent( mtw );
+
+  //*** a repeat is suppressed until the keepalive is due
+  now += 1000;
+  CHECK( !cache.changed( mtw ) );
+  CHECK( cache.getSuppressed()==1 );
+  now += CHANGE_KEEPALIVE;
+  CHECK( cache.changed( mtw ) );
+  cache.sent( mtw );
+  CHECK( !cache.changed( mtw ) );
+
+  //*** a new value passes at once
+  CHECK( receive( mtw, "$IIMTW,12.6,C" ) );
+  CHECK( cache.changed( mtw ) );
+  CHECK( cache.getSuppressed()==2 );
+}
+
+int main()
+{
+  testRateLimiter();
+  testRateLimiterBurst();
+  testChangeCache();
+  return report( "test_forward" );
+}
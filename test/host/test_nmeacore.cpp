@@ -0,0 +1,127 @@
+/*
+  Project:  Yazz_Multiplexer.ino, Copyright 2020, Roy Wassili
+  File:     test/host/test_nmeacore.cpp
+  Purpose:  Host tests of NMEACore.h: the fixed point math, the rewrite rules of
+            NMEA_SPECIALTY and the checksum test of a received sentence.
+*/
+
+#include "check.h"
+
+void testFixedParse()
+{
+  CHECK( fixedParse( "0017.6", 6, 1 )==176 );
+  CHECK( fixedParse( "13.2", 4, 1 )==132 );
+  CHECK( fixedParse( "-4.5", 4, 1 )==-45 );
+  CHECK( fixedParse( "+4", 2, 1 )==40 );
+  CHECK( fixedParse( " 7", 2, 1 )==70 );
+  //*** extra decimals round half away from zero
+  CHECK( fixedParse( "1.25", 4, 1 )==13 );
+  CHECK( fixedParse( "1.24", 4, 1 )==12 );
+  CHECK( fixedParse( "-1.25", 5, 1 )==-13 );
+  //*** like atof() it stops at the first character that is no part of the number
+  CHECK( fixedParse( "12.3,f", 6, 1 )==123 );
+  CHECK( fixedParse( "1.2.3", 5, 1 )==12 );
+  CHECK( fixedParse( "", 0, 1 )==0 );
+  CHECK( fixedParse( "f", 1, 1 )==0 );
+  //*** a number too large for an int32_t saturates
+  CHECK( fixedParse( "214748364.7", 11, 1 )==FIXED_MAX );
+  CHECK( fixedParse( "99999999999", 11, 1 )==FIXED_MAX );
+  CHECK( fixedParse( "-99999999999", 12, 1 )==-FIXED_MAX );
+  CHECK( fixedParse( "999999999", 9, 1 )==FIXED_MAX );
+}
+
+void testFixedScale()
+{
+  //*** feet to meters, rounded half away from zero
+  CHECK( fixedScale( 176, FTM_MUL, FTM_DIV )==54 );
+  CHECK( fixedScale( -176, FTM_MUL, FTM_DIV )==-54 );
+  CHECK( fixedScale( -1, FTM_MUL, FTM_DIV )==0 );
+  //*** the product does not overflow
+  CHECK( fixedScale( 9999999, FTM_MUL, FTM_DIV )==3048000 );
+  CHECK( fixedScale( FIXED_MAX, FTM_MUL, FTM_DIV )==654553016 );
+  //*** a result beyond an int32_t saturates
+  CHECK( fixedScale( FIXED_MAX, 10, 1 )==FIXED_MAX );
+  CHECK( fixedScale( -FIXED_MAX, 10, 1 )==-FIXED_MAX );
+  CHECK( fixedAdd( FIXED_MAX, BATTERY_OFFSET_FIXED )==FIXED_MAX );
+  CHECK( fixedAdd( -FIXED_MAX, -1 )==-FIXED_MAX );
+  CHECK( fixedAdd( 132, BATTERY_OFFSET_FIXED )==134 );
+}
+
+void testFixedFormat()
+{
+  char buf[FIXED_TEXT_SIZE];
+  CHECK_STR( fixedFormat( buf, 54, 1, 3 ), "5.4" );
+  CHECK_STR( fixedFormat( buf, 3, 1, 3 ), "0.3" );
+  CHECK_STR( fixedFormat( buf, -3, 1, 3 ), "-0.3" );
+  CHECK_STR( fixedFormat( buf, 0, 1, 3 ), "0.0" );
+  CHECK_STR( fixedFormat( buf, 0, 1, 3, true ), "-0.0" );
+  CHECK_STR( fixedFormat( buf, 54, 1, 5 ), "  5.4" );
+  CHECK_STR( fixedFormat( buf, 12345, 0, 3 ), "12345" );
+  CHECK_STR( fixedFormat( buf, 5, 2, 0 ), "0.05" );
+  //*** the longest result fits in FIXED_TEXT_SIZE
+  CHECK_STR( fixedFormat( buf, INT32_MIN, 1, 3 ), "-214748364.8" );
+  CHECK_STR( fixedFormat( buf, -FIXED_MAX, 1, FIXED_TEXT_SIZE-1 ), "-214748364.7" );
+  //*** a small negative value that rounds to 0 keeps its sign, like dtostrf()
+  CHECK( fixedBelowZero( "-0.05", 5, FTM_MUL, FTM_DIV, 0 ) );
+  CHECK( fixedBelowZero( "-0", 2, FTM_MUL, FTM_DIV, 0 ) );
+  CHECK( !fixedBelowZero( "0.01", 4, FTM_MUL, FTM_DIV, 0 ) );
+  CHECK( !fixedBelowZero( "-0.2", 4, 1, 1, BATTERY_OFFSET_FIXED ) );
+  CHECK( fixedBelowZero( "-0.21", 5, 1, 1, BATTERY_OFFSET_FIXED ) );
+  CHECK( !fixedBelowZero( "-0.19", 5, 1, 1, BATTERY_OFFSET_FIXED ) );
+}
+
+void testRewriteDBK()
+{
+  NMEAData nmea;
+  CHECK( receive( nmea, "$IIDBK,A,0017.6,f,,,," ) );
+  CHECK_STR( nmea.sentence, "$AODPT,5.4,0.0*4f\r\n" );
+  CHECK( nmea.tagId==TAG_dPT );
+  //*** a depth in meters is copied
+  CHECK( receive( nmea, "$IIDBK,A,5.4,M" ) );
+  CHECK( strncmp( nmea.sentence, "$AODPT,5.4,0.0*", 15 )==0 );
+  //*** line noise in the depth neither overflows nor wraps
+  CHECK( receive( nmea, "$IIDBK,A,999999.9,f" ) );
+  CHECK_STR( nmea.sentence, "$AODPT,304800.0,0.0*71\r\n" );
+  CHECK( receive( nmea, "$IIDBK,A,99999999999,f" ) );
+  CHECK( strncmp( nmea.sentence, "$AODPT,65455301.6,0.0*", 22 )==0 );
+  CHECK( receive( nmea, "$IIDBK,A,-0.05,f" ) );
+  CHECK_STR( nmea.sentence, "$AODPT,-0.0,0.0*63\r\n" );
+}
+
+void testRewriteTOB()
+{
+  NMEAData nmea;
+  CHECK( receive( nmea, "$PSTOB,13.2,v" ) );
+  CHECK_STR( nmea.sentence, "$AOXDR,U,13.4,V,BATT*58\r\n" );
+  CHECK( nmea.tagId==TAG_xDR );
+  CHECK( receive( nmea, "$PSTOB,99999999999,V" ) );
+  CHECK( strncmp( nmea.sentence, "$AOXDR,U,214748364.7,V,BATT*", 28 )==0 );
+  CHECK( receive( nmea, "$PSTOB,-0.2,V" ) );
+  CHECK( strncmp( nmea.sentence, "$AOXDR,U,0.0,V,BATT*", 20 )==0 );
+}
+
+void testChecksum()
+{
+  NMEAData nmea;
+  //*** a sentence without a checksum gets one, a good one is kept, a bad one is dropped
+  CHECK( receive( nmea, "$IIMTW,12.5,C" ) );
+  CHECK_STR( nmea.sentence, "$IIMTW,12.5,C*15\r\n" );
+  CHECK( receive( nmea, "$IIMTW,12.5,C*15" ) );
+  CHECK_STR( nmea.sentence, "$IIMTW,12.5,C*15\r\n" );
+  CHECK( !receive( nmea, "$IIMTW,12.5,C*16" ) );
+  CHECK( !receive( nmea, "$IIMTW,12.5,C*1" ) );
+  //*** an unknown tag takes the fast lane and is forwarded as received
+  CHECK( receive( nmea, "$GPXYZ,1,2*4F" ) );
+  CHECK( nmea.fastLane && nmea.tagId==TAG_UNKNOWN );
+}
+
+int main()
+{
+  testFixedParse();
+  testFixedScale();
+  testFixedFormat();
+  testRewriteDBK();
+  testRewriteTOB();
+  testChecksum();
+  return report( "test_nmeacore" );
+}
@@ -0,0 +1,97 @@
+/*
+  Project:  Yazz_Multiplexer.ino, Copyright 2020, Roy Wassili
+  File:     test/host/test_vessel.cpp
+  Purpose:  Host tests of VesselData.h: every tag in NMEA_DECODED decoded from a
+            converted sentence, the range checks and the staleness of a value.
+*/
+
+#define VESSEL_STALE 5000
+
+#include "check.h"
+#include <VesselData.h>
+
+static unsigned long now = 1000;
+unsigned long millis()
+{
+  return now;
+}
+
+//*** receive and convert str like the parser does and decode it into vessel
+void decode(VesselData &vessel, const char *str)
+{
+  NMEAData nmea;
+  CHECK( receive( nmea, str ) );
+  vessel.decode( nmea );
+}
+
+void testDecoders()
+{
+  VesselData vessel;
+  decode( vessel, "$GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W" );
+  CHECK( vessel.get( VESSEL_SOG )==224 );
+  CHECK( vessel.get( VESSEL_COG )==844 );
+  decode( vessel, "$IIVHW,,,,,5.2,N,," );
+  CHECK( vessel.get( VESSEL_STW )==52 );
+  decode( vessel, "$IIVWR,045.0,L,10.5,N,,,," );
+  CHECK( vessel.get( VESSEL_AWS )==105 );
+  CHECK( vessel.get( VESSEL_AWA )==-450 );
+  decode( vessel, "$IIVWR,030.0,R,11.0,N,,,," );
+  CHECK( vessel.get( VESSEL_AWA )==300 );
+  decode( vessel, "$AOHDG,123.4,,,1.57,E" );
+  CHECK( vessel.get( VESSEL_HEADING )==1234 );
+  //*** DBK and TOB are decoded after their conversion to DPT and XDR
+  decode( vessel, "$IIDBK,A,0017.6,f,,,," );
+  CHECK( vessel.get( VESSEL_DEPTH )==54 );
+  decode( vessel, "$PSTOB,13.2,V" );
+  CHECK( vessel.get( VESSEL_BATTERY )==134 );
+  decode( vessel, "$IIVLW,1234.5,N,12.3,N" );
+  CHECK( vessel.get( VESSEL_LOG )==12345 );
+  CHECK( vessel.get( VESSEL_TRIP )==123 );
+  decode( vessel, "$IIMTW,12.5,C" );
+  CHECK( vessel.get( VESSEL_WATER_TEMP )==125 );
+  for( byte q=0; q<VESSEL_COUNT; q++ ) CHECK( vessel.isKnown( q ) );
+}
+
+void testRanges()
+{
+  VesselData vessel;
+  //*** an empty field or a value out of range leaves the quantity as it was
+  decode( vessel, "$IIVHW,,,,,,N,," );
+  CHECK( !vessel.isKnown( VESSEL_STW ) );
+  decode( vessel, "$IIVHW,,,,,5.2,N,," );
+  decode( vessel, "$IIVHW,,,,,150.0,N,," );
+  CHECK( vessel.get( VESSEL_STW )==52 );
+  decode( vessel, "$IIVWR,361.0,R,10.5,N,,,," );
+  CHECK( !vessel.isKnown( VESSEL_AWA ) );
+  //*** an XDR of another transducer is no battery
+  decode( vessel, "$AOXDR,C,21.5,C,TEMP" );
+  CHECK( !vessel.isKnown( VESSEL_BATTERY ) );
+  //*** a tag that is not decoded sets nothing
+  decode( vessel, "$IIHDM,123.4,M" );
+  CHECK( !vessel.isKnown( VESSEL_HEADING ) );
+}
+
+void testStale()
+{
+  VesselData vessel;
+  now = 20000;
+  CHECK( vessel.isStale( VESSEL_STW ) );   // never decoded
+  decode( vessel, "$IIVHW,,,,,5.2,N,," );
+  CHECK( !vessel.isStale( VESSEL_STW ) );
+  CHECK( vessel.getStamp( VESSEL_STW )==20000 );
+  now += VESSEL_STALE-1;
+  CHECK( !vessel.isStale( VESSEL_STW ) );
+  now += 1;
+  CHECK( vessel.isStale( VESSEL_STW ) );
+  CHECK( vessel.get( VESSEL_STW )==52 );   // a stale value is kept
+  decode( vessel, "$IIVHW,,,,,5.3,N,," );
+  CHECK( !vessel.isStale( VESSEL_STW ) );
+}
+
+int main()
+{
+  testDecoders();
+  testRanges();
+  testStale();
+  return report( "test_vessel" );
+}
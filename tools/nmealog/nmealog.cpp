@@ -0,0 +1,582 @@
+/*
+  Project:  Yazz_Multiplexer.ino, Copyright 2020, Roy Wassili
+  File:     tools/nmealog/nmealog.cpp
+  Purpose:  Process recorded NMEA0183 logs on a PC (Linux) the way the NMEAtor does
+            on board. The sentence handling itself is NMEACore.h, the same code the
+            multiplexer runs, so every sentence is converted byte for byte the way
+            nmeaConvert() converts it on board. What the plotter receives also depends
+            on the queue, the rate limits, the change cache and the $PAOxx status
+            sentences, which are not part of this tool.
+
+            A log of many megabytes is handled in bulk: the whole log is scanned with
+            SSE2 or AVX2 for the characters that matter ($ ! ~ , * <CR> <LF>), the
+            positions are turned into sentences with field views in one pass and only
+            then the sentences are checked and converted. Sentences in NMEA_SPECIALTY
+            are rebuilt with NMEAData and the rewrite rules; all others are copied.
+            The scalar reference feeds every character through NMEAData::addChar()
+            exactly like NMEAListener::decode() in src/main.cpp does.
+
+  Usage:    nmealog [-f | -v | -b] [-g MB | file]
+            (none)  write the converted sentences to stdout, the drop counters to stderr
+            -f      write the fields of every received sentence, tab separated
+            -v      verify the vector parser against the scalar reference
+            -b      benchmark the scalar reference against SSE2 and AVX2
+            -g MB   use a generated log of MB megabytes instead of a file
+            Without a file the log is read from stdin.
+*/
+
+#include <NMEACore.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NMEALOG_X86 1
+#endif
+
+#define CHUNK_SIZE (1UL<<20)    // the log is scanned in chunks of 1 MB
+#define OUT_SIZE (1UL<<20)      // converted sentences are flushed per 1 MB
+#define BENCHMARK_RUNS 3        // the best run counts
+
+//*** a sentence found in the log. Like in NMEAData the field views are offsets from
+//*** the start delimiter and fieldIndex[nrOfFields] is one past the end of the last field.
+typedef struct {
+  size_t start;           // offset of the start delimiter in the log
+  byte length;            // nr of characters up to the <CR> or <LF>
+  byte nrOfFields;
+  byte fieldIndex[MAX_NMEA_FIELDS+1];
+  byte checksumIndex;     // position of the '*' or 0 if there is no checksum
+} LogSentence;
+
+//*** the converted sentences and the counters of a log
+typedef struct {
+  char out[OUT_SIZE+NMEA_SENTENCE_SIZE];
+  size_t used;
+  FILE *file;             // where the sentences go, or NULL to forget them
+  bool hashing;           // keep a hash of all output and field views, to verify
+  uint64_t outHash;
+  uint64_t indexHash;
+  unsigned long sentences;
+  unsigned long dropped[DROP_COUNT];
+} LogResult;
+
+typedef size_t (*ScanFunction)(const char *buf, size_t len, uint32_t *events);
+typedef byte (*CrcFunction)(const char *buf, size_t len);
+
+//*** FNV-1a, only to compare the results of two parsers
+uint64_t hashBytes(uint64_t h, const void *data, size_t len)
+{
+  const byte *p = (const byte *)data;
+  for( size_t i=0; i<len; i++ ) h = ( h ^ p[i] ) * 1099511628211ULL;
+  return h;
+}
+
+void resetResult(LogResult &result, FILE *file, bool hashing)
+{
+  result.used = 0;
+  result.file = file;
+  result.hashing = hashing;
+  result.outHash = result.indexHash = 14695981039346656037ULL;
+  result.sentences = 0;
+  memset( result.dropped, 0, sizeof(result.dropped) );
+}
+
+void flushResult(LogResult &result)
+{
+  if( result.file!=NULL ) fwrite( result.out, 1, result.used, result.file );
+  if( result.hashing ) result.outHash = hashBytes( result.outHash, result.out, result.used );
+  result.used = 0;
+}
+
+void putResult(LogResult &result, const char *str, size_t len)
+{
+  memcpy( result.out+result.used, str, len );
+  result.used += len;
+  if( result.used>=OUT_SIZE ) flushResult( result );
+}
+
+//*** the field views of the sentences the on board parser indexes, the ones not in
+//*** the fast lane, go into the index hash
+void hashFields(LogResult &result, size_t start, byte nrOfFields, const byte *fieldIndex, byte checksumIndex)
+{
+  result.indexHash = hashBytes( result.indexHash, &start, sizeof(start) );
+  result.indexHash = hashBytes( result.indexHash, &nrOfFields, 1 );
+  result.indexHash = hashBytes( result.indexHash, fieldIndex, nrOfFields+1 );
+  result.indexHash = hashBytes( result.indexHash, &checksumIndex, 1 );
+}
+
+/*
+   The scalar reference: every character goes through NMEAData::addChar(), with the
+   same states as NMEAListener::decode(), and every sentence through nmeaConvert().
+*/
+void convertScalar(const char *log, size_t len, LogResult &result)
+{
+  NMEAData nmea;
+  bool receiving = false;
+  size_t start = 0;
+
+  for( size_t i=0; i<len; i++ )
+  {
+    char c = log[i];
+    switch( c )
+    {
+      case '~':
+      case '!':
+      case '$':
+        if( receiving ) result.dropped[ DROP_UNTERMINATED ]++;
+        receiving = true;
+        start = i;
+        nmea.clear();
+        break;
+      case '\n':
+      case '\r':
+        if( receiving )
+        {
+          receiving = false;
+          if( result.hashing && !nmea.fastLane ) hashFields( result, start, nmea.nrOfFields, nmea.fieldIndex, nmea.checksumIndex );
+          if( nmeaConvert( nmea ) )
+          {
+            putResult( result, nmea.sentence, nmea.length );
+            result.sentences++;
+          } else result.dropped[ DROP_CHECKSUM ]++;
+        }
+        continue;
+    }
+    if( receiving && !nmea.addChar( c ) )
+    {
+      result.dropped[ DROP_OVERLONG ]++;
+      receiving = false;
+    }
+  }
+  flushResult( result );
+}
+
+/*
+   The scanners return the positions of the characters that start, split or end a
+   sentence. They differ only in how many characters they test at once.
+*/
+inline bool isStructural(char c)
+{
+  return ( c=='$' || c=='!' || c=='~' || c==',' || c=='*' || c=='\r' || c=='\n' );
+}
+
+size_t scanTail(const char *buf, size_t i, size_t len, uint32_t *events, size_t n)
+{
+  for( ; i<len; i++ ) if( isStructural( buf[i] ) ) events[n++] = i;
+  return n;
+}
+
+size_t scanScalar(const char *buf, size_t len, uint32_t *events)
+{
+  return scanTail( buf, 0, len, events, 0 );
+}
+
+byte crcScalar(const char *buf, size_t len)
+{
+  byte crc = 0;
+  for( size_t i=0; i<len; i++ ) crc ^= buf[i];
+  return crc;
+}
+
+#ifdef NMEALOG_X86
+__attribute__((target("sse2")))
+size_t scanSSE2(const char *buf, size_t len, uint32_t *events)
+{
+  const __m128i dollar = _mm_set1_epi8('$'), bang = _mm_set1_epi8('!'), tilde = _mm_set1_epi8('~');
+  const __m128i comma = _mm_set1_epi8(','), star = _mm_set1_epi8('*');
+  const __m128i cr = _mm_set1_epi8('\r'), lf = _mm_set1_epi8('\n');
+  size_t n = 0;
+  size_t i = 0;
+  for( ; i+16<=len; i+=16 )
+  {
+    __m128i v = _mm_loadu_si128( (const __m128i *)(buf+i) );
+    __m128i m = _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( v, dollar ), _mm_cmpeq_epi8( v, bang ) ),
+                              _mm_or_si128( _mm_cmpeq_epi8( v, tilde ), _mm_cmpeq_epi8( v, comma ) ) );
+    m = _mm_or_si128( m, _mm_or_si128( _mm_cmpeq_epi8( v, star ),
+                                       _mm_or_si128( _mm_cmpeq_epi8( v, cr ), _mm_cmpeq_epi8( v, lf ) ) ) );
+    unsigned mask = (unsigned)_mm_movemask_epi8( m );
+    while( mask )
+    {
+      events[n++] = i + __builtin_ctz( mask );
+      mask &= mask-1;
+    }
+  }
+  return scanTail( buf, i, len, events, n );
+}
+
+__attribute__((target("avx2")))
+size_t scanAVX2(const char *buf, size_t len, uint32_t *events)
+{
+  const __m256i dollar = _mm256_set1_epi8('$'), bang = _mm256_set1_epi8('!'), tilde = _mm256_set1_epi8('~');
+  const __m256i comma = _mm256_set1_epi8(','), star = _mm256_set1_epi8('*');
+  const __m256i cr = _mm256_set1_epi8('\r'), lf = _mm256_set1_epi8('\n');
+  size_t n = 0;
+  size_t i = 0;
+  for( ; i+32<=len; i+=32 )
+  {
+    __m256i v = _mm256_loadu_si256( (const __m256i *)(buf+i) );
+    __m256i m = _mm256_or_si256( _mm256_or_si256( _mm256_cmpeq_epi8( v, dollar ), _mm256_cmpeq_epi8( v, bang ) ),
+                                 _mm256_or_si256( _mm256_cmpeq_epi8( v, tilde ), _mm256_cmpeq_epi8( v, comma ) ) );
+    m = _mm256_or_si256( m, _mm256_or_si256( _mm256_cmpeq_epi8( v, star ),
+                                             _mm256_or_si256( _mm256_cmpeq_epi8( v, cr ), _mm256_cmpeq_epi8( v, lf ) ) ) );
+    uint32_t mask = (uint32_t)_mm256_movemask_epi8( m );
+    while( mask )
+    {
+      events[n++] = i + __builtin_ctz( mask );
+      mask &= mask-1;
+    }
+  }
+  return scanTail( buf, i, len, events, n );
+}
+
+//*** a sentence is at most NMEA_MAX_SENTENCE characters, so a few 16 byte XORs do
+__attribute__((target("sse2")))
+byte crcSSE2(const char *buf, size_t len)
+{
+  __m128i x = _mm_setzero_si128();
+  size_t i = 0;
+  for( ; i+16<=len; i+=16 ) x = _mm_xor_si128( x, _mm_loadu_si128( (const __m128i *)(buf+i) ) );
+  x = _mm_xor_si128( x, _mm_srli_si128( x, 8 ) );
+  x = _mm_xor_si128( x, _mm_srli_si128( x, 4 ) );
+  x = _mm_xor_si128( x, _mm_srli_si128( x, 2 ) );
+  x = _mm_xor_si128( x, _mm_srli_si128( x, 1 ) );
+  byte crc = (byte)_mm_cvtsi128_si32( x );
+  for( ; i<len; i++ ) crc ^= buf[i];
+  return crc;
+}
+#endif
+
+/*
+   Turns the positions of the scanners into sentences, with the same states as
+   NMEAListener::decode() and the same field views as NMEAData::addChar(). A sentence
+   may start in one chunk and end in the next.
+*/
+class LogFramer
+{
+  public:
+    //*** handle the structural character c at position pos of the log
+    inline void event(size_t pos, char c, std::vector<LogSentence> &batch, LogResult &result);
+    //*** the end of the log
+    void end(size_t len, LogResult &result);
+
+  private:
+    bool receiving=false;
+    LogSentence current;
+};
+
+inline void LogFramer::event(size_t pos, char c, std::vector<LogSentence> &batch, LogResult &result)
+{
+  bool regular = ( c==',' || c=='*' );
+  //*** any regular character beyond NMEA_MAX_SENTENCE does not fit on board
+  if( receiving && pos-current.start+( regular ? 1 : 0 ) > NMEA_MAX_SENTENCE )
+  {
+    result.dropped[ DROP_OVERLONG ]++;
+    receiving = false;
+  }
+  switch( c )
+  {
+    case '~':
+    case '!':
+    case '$':
+      if( receiving ) result.dropped[ DROP_UNTERMINATED ]++;
+      receiving = true;
+      current.start = pos;
+      current.nrOfFields = 1;
+      current.fieldIndex[0] = 0;
+      current.checksumIndex = 0;
+      break;
+    case ',':
+      if( receiving && current.checksumIndex==0 && current.nrOfFields<MAX_NMEA_FIELDS )
+        current.fieldIndex[ current.nrOfFields++ ] = pos-current.start+1;
+      break;
+    case '*':
+      if( receiving && current.checksumIndex==0 ) current.checksumIndex = pos-current.start;
+      break;
+    case '\n':
+    case '\r':
+      if( receiving )
+      {
+        receiving = false;
+        current.length = pos-current.start;
+        current.fieldIndex[ current.nrOfFields ] = ( current.checksumIndex>0 ? current.checksumIndex : current.length )+1;
+        batch.push_back( current );
+      }
+      break;
+  }
+}
+
+void LogFramer::end(size_t len, LogResult &result)
+{
+  //*** on board the sentence would already have been dropped
+  if( receiving && len-current.start > NMEA_MAX_SENTENCE ) result.dropped[ DROP_OVERLONG ]++;
+  receiving = false;
+}
+
+/*
+   Check and convert a batch of sentences. The checksum is tested with the crc of
+   the received characters; a sentence in NMEA_SPECIALTY is rebuilt by NMEAData and
+   the rewrite rules, all others only get a checksum if they had none.
+*/
+void convertBatch(const char *log, const std::vector<LogSentence> &batch, CrcFunction crcOf, LogResult &result)
+{
+  const char hex[] = "0123456789abcdef";
+  for( const LogSentence &s : batch )
+  {
+    const char *sentence = log+s.start;
+    byte crc = crcOf( sentence+1, ( s.checksumIndex>0 ? s.checksumIndex : s.length )-1 );
+    byte tagId = nmeaTagId( sentence, s.fieldIndex[1]-1 );
+    //*** the on board parser indexes all fields unless the tag at the first ',' takes the fast lane
+    if( result.hashing && ( s.nrOfFields==1 || nmeaTagHas( tagId, TAG_FIELDS ) ) )
+      hashFields( result, s.start, s.nrOfFields, s.fieldIndex, s.checksumIndex );
+    if( s.checksumIndex>0 )
+    {
+      int8_t hi = ( s.length==s.checksumIndex+3 ? hexValue( sentence[ s.checksumIndex+1 ] ) : -1 );
+      int8_t lo = ( s.length==s.checksumIndex+3 ? hexValue( sentence[ s.checksumIndex+2 ] ) : -1 );
+      if( hi<0 || lo<0 || ( (hi<<4) | lo )!=crc )
+      {
+        result.dropped[ DROP_CHECKSUM ]++;
+        continue;
+      }
+    }
+    if( nmeaTagHas( tagId, TAG_SPECIALTY ) )
+    {
+      NMEAData nmea;
+      for( byte i=0; i<s.length; i++ ) nmea.addChar( sentence[i] );
+      nmeaConvert( nmea );
+      putResult( result, nmea.sentence, nmea.length );
+    } else {
+      putResult( result, sentence, s.length );
+      if( s.checksumIndex==0 )
+      {
+        char cs[4] = { '*', hex[ crc>>4 ], hex[ crc & 0x0F ], '\0' };
+        putResult( result, cs, 3 );
+      }
+      putResult( result, NMEA_TERMINATOR, sizeof(NMEA_TERMINATOR)-1 );
+    }
+    result.sentences++;
+  }
+}
+
+//*** write the fields of a batch of sentences, tab separated, one sentence per line
+void printBatch(const char *log, const std::vector<LogSentence> &batch, LogResult &result)
+{
+  for( const LogSentence &s : batch )
+  {
+    for( byte i=0; i<s.nrOfFields; i++ )
+    {
+      if( i>0 ) putResult( result, "\t", 1 );
+      putResult( result, log+s.start+s.fieldIndex[i], s.fieldIndex[i+1]-s.fieldIndex[i]-1 );
+    }
+    putResult( result, "\n", 1 );
+    result.sentences++;
+  }
+}
+
+//*** scan, frame and convert (or print) the log chunk by chunk
+void convertVector(const char *log, size_t len, ScanFunction scan, CrcFunction crcOf, LogResult &result, bool fields)
+{
+  std::vector<uint32_t> events( CHUNK_SIZE );
+  std::vector<LogSentence> batch;
+  LogFramer framer;
+
+  batch.reserve( CHUNK_SIZE/16 );
+  for( size_t chunk=0; chunk<len; chunk+=CHUNK_SIZE )
+  {
+    size_t size = ( len-chunk<CHUNK_SIZE ? len-chunk : CHUNK_SIZE );
+    size_t nrOfEvents = scan( log+chunk, size, events.data() );
+    for( size_t e=0; e<nrOfEvents; e++ ) framer.event( chunk+events[e], log[ chunk+events[e] ], batch, result );
+    if( fields ) printBatch( log, batch, result );
+    else convertBatch( log, batch, crcOf, result );
+    batch.clear();
+  }
+  framer.end( len, result );
+  flushResult( result );
+}
+
+/*
+   A log for benchmarking and verifying: the sentences of the TEST stream of the
+   multiplexer, with now and then line noise, a lost <CR><LF> or garbage.
+*/
+char *generateLog(size_t size)
+{
+  static const char *sentences[] = {
+    "$IIVWR,151,R,02.4,N,,,,", "$IIMTW,12.2,C", "!AIVDM,1,1,,A,13aL<mhP000J9:PN?<jf4?vLP88B,0*2B",
+    "$IIDBK,A,0014.4,f,,,,", "$IIVLW,1149.1,N,001.07,N", "$GPGLL,5251.3091,N,00541.8037,E,151314.000,A,D*5B",
+    "$GPRMC,095218.000,A,5251.5621,N,00540.8482,E,4.25,201.77,120420,,,D*6D", "$PSTOB,13.0,v",
+    "$IIVWR,151,R,02.3,N,,,,", "$IIVHW,,,000,M,01.57,N,,", "$IIDBK,A,0017.6,f,,,,", "$PSTOB,12.9,V",
+    "$GPGGA,095218.000,5251.5621,N,00540.8482,E,2,09,1.0,-2.1,M,46.8,M,,0000*70",
+    "$GPGSA,A,3,14,32,22,31,10,27,26,18,20,,,,1.8,1.0,1.5*33",
+    "$GPGSV,3,1,12,14,72,232,43,32,65,129,44,22,53,075,41,31,42,292,40*7C",
+    "!AIVDM,1,1,,B,33aL<mhP000J9:PN?<jf4?vLP88B,0*2A", "$IIVWR,148,R,02.6,N,,,,", "$IIVHW,,,000,M,01.61,N,,"
+  };
+  const size_t nrOfSentences = sizeof(sentences)/sizeof(sentences[0]);
+  char *log = (char *)malloc( size );
+  uint32_t random = 61;
+  size_t used = 0;
+
+  if( log==NULL ) return NULL;
+  while( used<size )
+  {
+    char line[2*NMEA_BUFFER_SIZE];
+    random = random*1103515245 + 12345;
+    const char *sentence = sentences[ (random>>16) % nrOfSentences ];
+    size_t len = strlen( sentence );
+    memcpy( line, sentence, len );
+    switch( (random>>8) & 63 )
+    {
+      case 0: line[ 1+(random>>20) % (len-1) ] ^= 0x01; break;     // line noise
+      case 1: len--; break;                                        // lost the end, and so the <CR><LF>
+      case 2: memset( line+len, 'x', NMEA_BUFFER_SIZE ); len += NMEA_BUFFER_SIZE; break;
+    }
+    if( ( (random>>8) & 63 )!=1 )
+    {
+      line[len++] = '\r';
+      line[len++] = '\n';
+    }
+    if( used+len>size ) len = size-used;
+    memcpy( log+used, line, len );
+    used += len;
+  }
+  return log;
+}
+
+//*** map a log file, or read it from stdin
+const char *readLog(const char *path, size_t &len)
+{
+  if( path!=NULL )
+  {
+    int fd = open( path, O_RDONLY );
+    struct stat st;
+    if( fd<0 || fstat( fd, &st )<0 ) return NULL;
+    len = st.st_size;
+    void *log = ( len>0 ? mmap( NULL, len, PROT_READ, MAP_PRIVATE, fd, 0 ) : MAP_FAILED );
+    close( fd );
+    return ( log==MAP_FAILED ? ( len==0 ? "" : NULL ) : (const char *)log );
+  }
+  size_t size = 1<<20;
+  char *log = (char *)malloc( size );
+  len = 0;
+  for( size_t n; log!=NULL && ( n=fread( log+len, 1, size-len, stdin ) )>0; )
+  {
+    len += n;
+    if( len==size ) log = (char *)realloc( log, size *= 2 );
+  }
+  return log;
+}
+
+double seconds()
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+void reportDrops(const LogResult &result)
+{
+  fprintf( stderr, "%lu sentences, dropped: %lu bad checksum, %lu overlong, %lu unterminated\n",
+           result.sentences, result.dropped[ DROP_CHECKSUM ], result.dropped[ DROP_OVERLONG ],
+           result.dropped[ DROP_UNTERMINATED ] );
+}
+
+//*** the best of BENCHMARK_RUNS runs in MB/s; scan is NULL for the scalar reference
+void benchmark(const char *label, const char *log, size_t len, ScanFunction scan, CrcFunction crcOf, LogResult &result)
+{
+  double best = 0;
+  for( int r=0; r<BENCHMARK_RUNS; r++ )
+  {
+    resetResult( result, NULL, false );
+    double start = seconds();
+    if( scan==NULL ) convertScalar( log, len, result );
+    else convertVector( log, len, scan, crcOf, result, false );
+    double elapsed = seconds()-start;
+    if( r==0 || elapsed<best ) best = elapsed;
+  }
+  double mbs = len/best/1e6;
+  printf( "%-18s %9.1f MB/s %7.1f GB/min\n", label, mbs, mbs*60/1000 );
+}
+
+int main(int argc, char *argv[])
+{
+  char mode = 'c';
+  size_t generate = 0;
+  const char *path = NULL;
+  int opt;
+
+  while( ( opt=getopt( argc, argv, "fvbg:" ) )!=-1 )
+  {
+    switch( opt )
+    {
+      case 'f':
+      case 'v':
+      case 'b':
+        mode = opt;
+        break;
+      case 'g':
+        generate = strtoul( optarg, NULL, 10 )<<20;
+        break;
+      default:
+        fprintf( stderr, "usage: %s [-f | -v | -b] [-g MB | file]\n", argv[0] );
+        return 2;
+    }
+  }
+  if( optind<argc ) path = argv[optind];
+
+  size_t len = generate;
+  const char *log = ( generate>0 ? generateLog( generate ) : readLog( path, len ) );
+  if( log==NULL )
+  {
+    perror( path!=NULL ? path : "nmealog" );
+    return 1;
+  }
+
+  ScanFunction scan = scanScalar;
+  CrcFunction crcOf = crcScalar;
+  #ifdef NMEALOG_X86
+  scan = ( __builtin_cpu_supports("avx2") ? scanAVX2 : scanSSE2 );
+  crcOf = crcSSE2;
+  #endif
+
+  static LogResult result, reference;
+  switch( mode )
+  {
+    case 'c':
+    case 'f':
+      resetResult( result, stdout, false );
+      convertVector( log, len, scan, crcOf, result, mode=='f' );
+      if( mode=='c' ) reportDrops( result );
+      return 0;
+
+    case 'v':
+    {
+      resetResult( reference, NULL, true );
+      convertScalar( log, len, reference );
+      resetResult( result, NULL, true );
+      convertVector( log, len, scan, crcOf, result, false );
+      bool same = ( result.outHash==reference.outHash && result.indexHash==reference.indexHash &&
+                    result.sentences==reference.sentences &&
+                    memcmp( result.dropped, reference.dropped, sizeof(result.dropped) )==0 );
+      reportDrops( reference );
+      printf( "%s\n", same ? "identical to the scalar reference" : "DIFFERS from the scalar reference" );
+      return ( same ? 0 : 1 );
+    }
+
+    case 'b':
+      printf( "%zu bytes\n", len );
+      benchmark( "scalar reference", log, len, NULL, NULL, result );
+      benchmark( "vector, scalar", log, len, scanScalar, crcScalar, result );
+      #ifdef NMEALOG_X86
+      benchmark( "vector, SSE2", log, len, scanSSE2, crcSSE2, result );
+      if( __builtin_cpu_supports("avx2") ) benchmark( "vector, AVX2", log, len, scanAVX2, crcSSE2, result );
+      #endif
+      return 0;
+  }
+  return 0;
+}